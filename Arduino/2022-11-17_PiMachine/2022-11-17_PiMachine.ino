@@ -7,6 +7,32 @@
 #include <rgb.h>
 #include <printer.h>
 #include <chrono.h>
+#include <sched.h>
+#include <digit_cache.h>
+#include <digit_sink.h>
+#if defined(HOST_HAL)
+#include <file_sink.h>
+#endif
+
+// if 1, save progress to the QSPI flash and pick up from there after a reset
+// or the battery running flat
+#define CHECKPOINT 1
+
+// if 0, ignore any saved progress at boot and start at the beginning
+#define CHECKPOINT_RESUME 1
+
+// if 1, keep a record of compute time, waits, and backing up by digit
+// position, saved to the QSPI flash (see telemetry.h)
+#define TELEMETRY 1
+
+#if CHECKPOINT || TELEMETRY
+#include <checkpoint.h>
+#include <qspi_flash.h>
+#endif
+
+#if TELEMETRY
+#include <telemetry.h>
+#endif
 
 // if 1, wait for serial (usb) console before starting
 #define WAIT_CONSOLE 0
@@ -14,6 +40,32 @@
 // if 1, print to real printer in addition to console
 #define PRINT_DIGITS 1
 
+// if 1, the console gets fixed-size binary frames instead of text lines
+// (see SerialBinarySink)
+#define CONSOLE_BINARY 0
+
+// if 1, printer bytes are queued and go out by DMA, so the next digit is
+// computing while the last line is still on the wire (see serial_dma.h)
+#define PRINTER_DMA 1
+
+#if PRINTER_DMA
+#include <serial_dma.h>
+#endif
+
+// if 1, keep track of which lines might not be on the paper yet, so the
+// printer can go as fast as it prints instead of being paced to make sure
+// each line is done (see print_journal.h); needs PRINT_DIGITS
+#define PRINT_JOURNAL 1
+
+#if !PRINT_DIGITS
+#undef PRINT_JOURNAL
+#define PRINT_JOURNAL 0
+#endif
+
+#if PRINT_JOURNAL
+#include <print_journal.h>
+#endif
+
 // if 1, check for paper out (can do this without printing digits)
 #define CHECK_PAPER 1
 
@@ -28,17 +80,30 @@ static const int paper_fake_yes = 1; // gpio when "paper is present"
 #define CHECK_POWER 1
 
 // Minimum number of milliseconds per digit printed.
-// 250 seems to be about the fastest, slower for debugging.
-#if PRINT_DIGITS
-static const Interval print_interval(500);
-#else
+// 250 seems to be about the fastest, slower for debugging. With the
+// journal, the printer sets the pace.
+#if PRINT_JOURNAL || !PRINT_DIGITS
 static const Interval print_interval(0);
+#else
+static const Interval print_interval(500);
 #endif
 
+// Longest a line takes to print, for the journal to know when it's done.
+static const Interval print_line_time(250);
+
 // 19200 for the Mini, 9600 for the Nano
 static const int printer_baud = 19200;
 
+#if !PRINTER_DMA
 static Printer printer(Serial1);
+#elif defined(HOST_HAL)
+static SerialDma printer_tx(Serial1);
+static Printer printer(Serial1, &printer_tx);
+#else
+// Serial1 is SERCOM5 on the Feather M4
+static SerialDma printer_tx(SERCOM5, SERCOM5_DMAC_ID_TX);
+static Printer printer(Serial1, &printer_tx);
+#endif
 
 static const int red_pin = 5;
 static const int green_pin = 6;
@@ -49,6 +114,10 @@ static Rgb led(red_pin, green_pin, blue_pin);
 // The start time is advanced when waiting for power or paper.
 static Time start_time;
 
+// Printed timestamps are this plus time since start_time; it is the
+// timestamp we had got to when resuming from a checkpoint.
+static Interval elapsed_offset;
+
 // In the program, first digit after the decimal (the 1) is digit zero
 // (that is dictated by DigitsOfPi).
 //
@@ -60,11 +129,254 @@ static Time start_time;
 static const int32_t digit_num_start = -4;
 static int32_t digit_num = digit_num_start;
 
+// How far to back up after paper out and power out (see paper_wait and
+// power_wait), from the oldest line that might not have printed
+static const int32_t paper_back_up = 20;
+static const int32_t power_back_up = 3;
+
+
+// Waiting for something that might never happen; the wait loops go back
+// around after this long anyway.
+static const Interval wait_forever(60000);
 
 // How long it took to calculate the most recent digit.
 // loop() sets this and print_digit() uses it.
 static Interval digit_interval;
 
+// Digits recently computed, for reprinting after backing up.
+static DigitCache digit_cache;
+
+
+// Where the digits go. Each sink has its own queue, so a console nobody is
+// reading can't hold up the printer. The text console drops lines when it
+// falls behind; binary frames coalesce, so whatever is reading them gets the
+// latest digit when it catches up (every frame has its position).
+
+static int console_room()
+{
+  return Serial.availableForWrite();
+}
+
+#if CONSOLE_BINARY
+static SerialBinarySink console_sink(Serial, console_room);
+static SinkQueue console_queue(console_sink, SinkQueue::Coalesce);
+#else
+static SerialTextSink console_sink(Serial, console_room);
+static SinkQueue console_queue(console_sink, SinkQueue::Drop);
+#endif
+
+#if PRINT_JOURNAL
+static PrintJournal journal(printer, print_line_time);
+static PrinterSink printer_sink(printer, print_interval, &journal);
+#elif PRINT_DIGITS
+static PrinterSink printer_sink(printer, print_interval);
+#endif
+#if PRINT_DIGITS
+static SinkQueue printer_queue(printer_sink, SinkQueue::Block);
+#endif
+
+#if defined(HOST_HAL)
+// simulator --digits FILE
+static FileSink file_sink;
+static SinkQueue file_queue(file_sink, SinkQueue::Drop);
+#endif
+
+static DigitFanout fanout;
+
+
+// Where to go back to when lines might have been lost: 'margin' before the
+// oldest line that isn't known to be on the paper.
+static int32_t back_up_to(int32_t margin)
+{
+#if PRINT_JOURNAL
+  int32_t n = journal.oldest(digit_num) - margin;
+#else
+  int32_t n = digit_num - margin;
+#endif
+  return n < digit_num_start ? digit_num_start : n;
+}
+
+
+#if CHECKPOINT || TELEMETRY
+static QspiFlash flash;
+static bool flash_ok = false;
+#endif
+
+// Checkpoints go in the last 64K of the 2M flash (256 of them before the
+// ring comes around). At one a minute, each sector is erased about once a
+// day; the flash is good for 100,000.
+static const uint32_t checkpoint_size = 64 * 1024;
+
+#if CHECKPOINT
+
+static const Interval checkpoint_interval(60000);
+
+static CheckpointStore checkpoints(flash);
+
+struct Checkpoint {
+  uint32_t version;
+  int32_t digit_num;    // where to start printing
+  int64_t elapsed_ms;   // timestamp to continue from
+  int32_t digits_end;   // digit_cache contents, up to (not including) this
+  char digits[DigitCache::size];
+};
+
+static const uint32_t checkpoint_version = 2;
+
+static Time last_checkpoint;
+
+#endif // CHECKPOINT
+
+
+// Save where we are, backed up by back_up digits (a checkpoint that is
+// only ever read after losing power should back up as if that happened).
+static void checkpoint_save(int32_t back_up)
+{
+#if CHECKPOINT
+  Checkpoint cp;
+  cp.version = checkpoint_version;
+  cp.digit_num = digit_num - back_up;
+  if (cp.digit_num < digit_num_start)
+    cp.digit_num = digit_num_start;
+  cp.elapsed_ms = (elapsed_offset + (Time::now() - start_time)).ms();
+  cp.digits_end = digit_num + 1;
+  digit_cache.save(cp.digits_end, cp.digits);
+  if (!checkpoints.save(&cp, sizeof(cp)))
+    Serial.println("checkpoint save failed");
+  last_checkpoint = Time::now();
+#endif
+}
+
+
+// Pick up from the newest checkpoint, if there is one.
+static void checkpoint_resume()
+{
+#if CHECKPOINT
+  const Time resume_start;
+
+  if (!flash_ok) {
+    Serial.println("checkpoint: no flash");
+    return;
+  }
+  if (!checkpoints.begin(flash.size() - checkpoint_size, checkpoint_size)) {
+    Serial.println("checkpoint: can't read flash");
+    return;
+  }
+
+  Checkpoint cp;
+  if (CHECKPOINT_RESUME &&
+      checkpoints.load(&cp, sizeof(cp)) == sizeof(cp) &&
+      cp.version == checkpoint_version && cp.digit_num >= digit_num_start) {
+    digit_num = cp.digit_num;
+    elapsed_offset = Interval(cp.elapsed_ms);
+    digit_cache.restore(cp.digits_end, cp.digits);
+    Serial.print("resuming at digit ");
+    Serial.print(digit_num + 1);
+    Serial.print(" from checkpoint ");
+    Serial.print(checkpoints.seq());
+  } else {
+    Serial.print("starting over");
+  }
+  Serial.print(" (");
+  Serial.print((long)(Time::now() - resume_start).ms());
+  Serial.println(" ms)");
+
+  last_checkpoint = Time::now();
+#endif
+}
+
+
+// Save a checkpoint if it has been a while.
+static void checkpoint_maybe()
+{
+#if CHECKPOINT
+  if (!(Time::now() - last_checkpoint < checkpoint_interval))
+    checkpoint_save(digit_num - back_up_to(0));
+#endif
+}
+
+
+#if TELEMETRY
+
+// Telemetry goes just below the checkpoints (16K, two copies). Saved once an
+// hour, each sector is erased every other hour.
+static const Interval telemetry_interval(60L * 60 * 1000);
+
+static Telemetry telemetry;
+
+static Time last_telemetry;
+
+#endif // TELEMETRY
+
+
+static void telemetry_begin()
+{
+#if TELEMETRY
+  if (!flash_ok) {
+    Serial.println("telemetry: no flash");
+    return;
+  }
+  uint32_t size = Telemetry::region_size(flash.sector_size());
+  if (!telemetry.begin(flash, flash.size() - checkpoint_size - size, size)) {
+    Serial.println("telemetry: can't use flash");
+  } else if (telemetry.image().seq != 0) {
+    Serial.print("telemetry: ");
+    Serial.print((long)(telemetry.image().run_ms / 3600000));
+    Serial.println(" hours so far");
+  }
+  last_telemetry = Time::now();
+#endif
+}
+
+
+static void telemetry_save()
+{
+#if TELEMETRY
+  if (!telemetry.save())
+    Serial.println("telemetry save failed");
+  last_telemetry = Time::now();
+#endif
+}
+
+
+// Save the telemetry if it has been a while.
+static void telemetry_maybe()
+{
+#if TELEMETRY
+  if (!(Time::now() - last_telemetry < telemetry_interval))
+    telemetry_save();
+#endif
+}
+
+
+// return true if 5V supply is present, false otherwise
+static bool check_power()
+{
+
+#if CHECK_POWER
+
+  // VUSB is 5.0V when plugged in, and is about 3.3V when not plugged in.
+  // The pin is half that. Set threshold for halfway between 5.0 and 3.3.
+  // Halfway between 3.3 and 5.0 is 4.15V.
+  // Pin is half that, or 2.075V.
+  // ADC reading is 1024 at 3.3V, so ADC threshold is 644.
+  const int v_thresh = 644;
+  int v = analogRead(2);
+
+  return (v >= v_thresh);
+
+#else // CHECK_POWER
+
+  return true;
+
+#endif // CHECK_POWER
+
+} // check_power
+
+
+// The ADC is cheap to read, so sample it often.
+static Sampler power(check_power, Interval(20));
+
 
 #if CHECK_PAPER || CHECK_PAPER_FAKE
 
@@ -73,14 +385,36 @@ static bool check_paper()
 {
 #if CHECK_PAPER_FAKE
   return (digitalRead(paper_fake_pin) == paper_fake_yes);
+#elif PRINT_JOURNAL
+  return journal.check();
 #else
   return printer.paper();
 #endif
 }
 
+// Paper status query takes several msec, so don't do it too often.
+static Sampler paper(check_paper, Interval(100));
+
 #endif // CHECK_PAPER || CHECK_PAPER_FAKE
 
 
+// paper_wait() is in progress (it can call power_wait())
+static bool waiting_for_paper = false;
+
+
+// How well digit_cache is doing
+static void print_cache_stats()
+{
+  Serial.print("digit cache: ");
+  Serial.print(digit_cache.hits);
+  Serial.print(" hits, ");
+  Serial.print(digit_cache.misses);
+  Serial.print(" misses, ");
+  Serial.print((long)(digit_cache.saved.ms() / 1000));
+  Serial.println(" s saved");
+}
+
+
 // If paper is detected, return true immediately.
 // If paper is not detected, wait for it to be detected continuously
 // for 10 seconds, then return false.
@@ -96,6 +430,25 @@ static bool paper_wait()
 
   Serial.println("paper out");
 
+  // Back up 20 digits before anything that might not have printed. A nice
+  // clean end-of-paper loses only what was in the printer, which the
+  // journal knows (or, without it, the line just printed), but sometimes
+  // the end of the roll is folded back on itself and a couple of inches at
+  // the end don't print because it's trying to print on the back of the
+  // paper. We're printing about 8.5 lines per inch.
+  const int32_t back_to = back_up_to(paper_back_up);
+#if PRINT_JOURNAL
+  journal.clear();
+#endif
+
+  // where the paper ran out (a power out while waiting moves digit_num)
+  const int32_t out_at = digit_num;
+
+  // If the battery runs out while we wait, come back as if the paper had
+  // been changed.
+  checkpoint_save(digit_num - back_to);
+  waiting_for_paper = true;
+
   // Time we started waiting for more paper. This is used to adjust the global
   // start_time so it doesn't include paper-out time.
   const Time wait_start;
@@ -103,42 +456,49 @@ static bool paper_wait()
   // Need to see paper for 10 seconds before continuing.
   const Interval wait_timeout(10000);
 
-  // Last time paper was detected as "out".
-  Time paper_out;
+  // Paper, power, and LED all get looked at when they need it; in between,
+  // the core sleeps.
+  Sched sched;
+  sched.add(paper);
+  sched.add(power);
+  sched.add(led);
 
-  while ((Time::now() - paper_out) < wait_timeout) {
+  paper.begin();
+  power.begin();
 
-    if (!power_wait()) {
-      // power went away, then came back
-      paper_out = Time::now();
+  while (!paper.level() || (Time::now() - paper.changed()) < wait_timeout) {
+
+    if (!power.level()) {
+      // power went away; this waits for it to come back
+      power_wait();
+      // start the 10 seconds over
+      power.begin();
+      paper.begin();
     }
 
-    if (check_paper()) {
+    if (paper.level()) {
       // solid red means we see paper, waiting for 10 seconds
       led.set(Rgb::Red);
+      sched.wait(paper.changed() + wait_timeout);
     } else {
       // winking red means we don't see paper
       led.pattern(Rgb::Red, 10, Rgb::Off, 990);
-      paper_out = Time::now();
+      sched.wait(Time::now() + wait_forever);
     }
 
-    led.loop(); // handle blinking
-
-    yield(); // could be in this while loop for a long time
-
   } // while
 
   // Adjust start_time as if we didn't have to wait.
   start_time += (Time::now() - wait_start);
 
-  // Back up 30 digits after paper out. A nice clean end-of-paper only needs
-  // a few digits of backing up (4 or 5 might do), but sometimes the end of
-  // the roll is folded back on itself and a couple of inches at the end
-  // don't print because it's trying to print on the back of the paper.
-  // We're printing about 8.5 lines per inch.
-  digit_num -= 30;
-  if (digit_num < digit_num_start)
-    digit_num = digit_num_start;
+#if TELEMETRY
+  telemetry.wait(out_at, Telemetry::Paper, Time::now() - wait_start,
+                 out_at - back_to);
+#endif
+
+  digit_num = back_to;
+
+  waiting_for_paper = false;
 
   Serial.println("paper okay");
 
@@ -153,31 +513,6 @@ static bool paper_wait()
 } // paper_wait
 
 
-// return true if 5V supply is present, false otherwise
-static bool check_power()
-{
-
-#if CHECK_POWER
-
-  // VUSB is 5.0V when plugged in, and is about 3.3V when not plugged in.
-  // The pin is half that. Set threshold for halfway between 5.0 and 3.3.
-  // Halfway between 3.3 and 5.0 is 4.15V.
-  // Pin is half that, or 2.075V.
-  // ADC reading is 1024 at 3.3V, so ADC threshold is 644.
-  const int v_thresh = 644;
-  int v = analogRead(2);
-
-  return (v >= v_thresh);
-
-#else // CHECK_POWER
-
-  return true;
-
-#endif // CHECK_POWER
-
-} // check_power
-
-
 static bool power_wait()
 {
 
@@ -186,6 +521,21 @@ static bool power_wait()
 
   Serial.println("power out");
 
+  // Back up three digits before anything that might not have printed; the
+  // printer forgets whatever it hadn't printed yet, and the last line might
+  // be chopped off. Maybe there's some other case where more than one
+  // might be lost, and losing a digit would be most terrible.
+  const int32_t back_to = back_up_to(power_back_up);
+#if PRINT_JOURNAL
+  journal.clear();
+#endif
+
+  // On battery now, which might not last; save right away. (If we were
+  // already waiting for paper, that saved a checkpoint backed up farther.)
+  if (!waiting_for_paper)
+    checkpoint_save(digit_num - back_to);
+  telemetry_save();
+
   // Wait to be plugged in for at least 1 sec, then return false.
   // The delay is to let the printer boot up.
   // Returning false prevents the just-calculated digit from being printed.
@@ -194,37 +544,47 @@ static bool power_wait()
 
   const Interval wait_timeout(1000); // 1 second
 
-  // last time power was seen low
-  Time power_low;
+  // Could be here for hours on battery; sleep as much as possible. The
+  // scheduler wakes up to sample the ADC and to blink the LED.
+  Sched sched;
+  sched.add(power);
+  sched.add(led);
+
+  power.begin();
 
-  while ((Time::now() - power_low) < wait_timeout) {
+  while (!power.level() || (Time::now() - power.changed()) < wait_timeout) {
 
-    if (check_power()) {
+    if (power.level()) {
       // solid blue means we see 5V power, waiting 1 second
       led.set(Rgb::Blue);
+      sched.wait(power.changed() + wait_timeout);
     } else {
       // winking blue means we don't see 5V power
       led.pattern(Rgb::Blue, 10, Rgb::Off, 990);
-      power_low = Time::now();
+      sched.wait(Time::now() + wait_forever);
     }
 
-    led.loop(); // handle blinking
-
-    yield(); // could be in this while loop for hours
-
   } // while
 
   // Adjust start_time as if we didn't have to wait.
   start_time += (Time::now() - wait_start);
 
-  // Back up three digits after power outage; really only the previous one
-  // might be chopped off, but maybe there's some other case where more than
-  // one might be lost, and losing a digit would be most terrible.
-  digit_num -= 3;
-  if (digit_num < digit_num_start)
-    digit_num = digit_num_start;
+#if TELEMETRY
+  // (while waiting for paper, backing up for the paper covers this)
+  telemetry.wait(digit_num, Telemetry::Power, Time::now() - wait_start,
+                 waiting_for_paper ? 0 : digit_num - back_to);
+#endif
 
-  Serial.println("power okay");
+  digit_num = back_to;
+
+#if PRINT_JOURNAL
+  // it has booted up again, without automatic status
+  printer.auto_status(true);
+#endif
+
+  Serial.print("power okay (asleep ");
+  Serial.print(Sched::slept_ms);
+  Serial.println(" ms total)");
 
   return false;
 
@@ -232,94 +592,37 @@ static bool power_wait()
 
 
 // print a digit (paper and power already checked)
-// 
-static void print_digit(char digit)
+//
+// Returns false if the printer's queue didn't take it in wait_forever; loop()
+// then checks power and paper and comes back to it (from the cache).
+static bool print_digit(char digit)
 {
-  // Limit print rate so we don't queue up lines in the receive buffer,
-  // which breaks paper-out handling. This is different from worrying
-  // about overrunning the receive buffer; we basically want to know a
-  // digit is on the paper before we try to print another one.
-  static Time last_print_time;
-  while ((Time::now() - last_print_time) < print_interval)
-    delay(1);
-  last_print_time = Time::now();
-
-  // timestamp that will print with digit
-  uint32_t h, m, s, ms;
-  (last_print_time - start_time).hmsm(h, m, s, ms);
+  DigitRecord r;
 
   // digit number to print
-  int32_t pr_digit_num;
   if (digit_num == -2)
-    pr_digit_num = 0; // initial '3'
+    r.num = 0; // initial '3'
   else
-    pr_digit_num = digit_num + 1;
-
-  // large font is 12 pixels wide x 24 pixels high
-
-  // rotated and doubled digit is 48 pixels wide
-  // digit should be centered on 384/2 = 192, so should print at
-  // 192 - (48 / 2) = 168
+    r.num = digit_num + 1;
 
-  // line will be:
-  // digit number: 12 chars @ 12 pixels = 144 pixels
-  // border:        2 chars @ 12 pixels =  24 pixels
-  // digit:         1 char  @ 48 pixels =  48 pixels
-  // border:        2 chars @ 12 pixels =  24 pixels
-  // timestamp:    12 chars @ 12 pixels = 144 pixels
-  // total:                               384 pixels
-
-  char buf[50];
-
-  // only print number and timestamp if digit is 0..9
-  if ('0' <= digit && digit <= '9')
-    sprintf(buf, "%-12ld| %c |%6lu:%02lu:%02lu", pr_digit_num, digit, h, m, s);
-  else
-    sprintf(buf, "            | %c |            ", digit);
-  Serial.print(buf);
+  r.pos = digit_num;
 
-  sprintf(buf, "%9lld", digit_interval.ms());
-  Serial.print(buf);
+  r.digit = digit;
 
-  Serial.println();
+  // timestamp that will print with digit
+  r.elapsed_ms = (elapsed_offset + (Time::now() - start_time)).ms();
 
-#if PRINT_DIGITS
+  r.compute_ms = int32_t(digit_interval.ms());
 
-  // digit number
-  if ('0' <= digit && digit <= '9')
-    sprintf(buf, "%-12ld", pr_digit_num); // 12 chars left-justified
-  else
-    strcpy(buf, "            "); // 12 chars
-
-  printer.rotate(false);
-  printer.mode(Printer::Modes::FontLarge);
-  printer.print(buf);
-  printer.print(0xb2); // gray box
-  printer.print(' ');
-
-  // digit
-  printer.rotate(true);
-  printer.mode(Printer::Modes::FontLarge | Printer::Modes::BoldOn |
-               Printer::Modes::Height2x | Printer::Modes::Width2x);
-  printer.print(digit);
-
-  // Timestamp. This will run up against the digit in 11 years, then
-  // do something uglier in 114 years.
-  printer.rotate(false);
-  printer.mode(Printer::Modes::FontLarge);
-  printer.print(' ');
-  printer.print(0xb2); // gray box
-  if ('0' <= digit && digit <= '9') {
-    sprintf(buf, "%6lu:%02lu:%02lu", h, m, s); // 12 chars right-justified
-    printer.print(buf);
-  }
+  if (!fanout.put(r, Time::now() + wait_forever))
+    return false;
 
-  printer.line_space(0);  // lines as close together as possible
-  printer.flush();        // print buffered data and advance paper
+  // The printer's queue is Block, and PrinterSink paces it; wait here until
+  // the line has gone out, so paper and power are checked between lines
+  // just as before. The console and the rest don't hold this up.
+  fanout.drain(Time::now() + wait_forever);
 
-  printer.mode(); // defaults
-
-#endif // PRINT_DIGITS
+  return true;
 
 } // print_digit
 
@@ -351,10 +654,30 @@ void setup()
   printer.begin(printer_baud);
   delay(250);
 
-  start_time = Time::now();
+#if PRINT_JOURNAL
+  printer.auto_status(true);
+#endif
+
+  fanout.add(console_queue);
+#if PRINT_DIGITS
+  fanout.add(printer_queue);
+#endif
+#if defined(HOST_HAL)
+  if (file_sink.enabled())
+    fanout.add(file_queue);
+#endif
 
   digit_num = digit_num_start;
 
+#if CHECKPOINT || TELEMETRY
+  flash_ok = flash.begin();
+#endif
+
+  checkpoint_resume();
+  telemetry_begin();
+
+  start_time = Time::now();
+
 } // setup
 
 
@@ -366,6 +689,10 @@ static const char *pi50 =
     "  3.1415926535897932384626433832795028841971693993751058209";
 
 
+// Reprinting digits from digit_cache
+static bool reprinting = false;
+
+
 void loop()
 {
   led.set(Rgb::Green);
@@ -381,14 +708,30 @@ void loop()
 
     digit_char = pi50[digit_num + 4];
 
+  } else if (digit_cache.get(digit_num, digit_char)) {
+
+    // computed before backing up after paper or power out
+    reprinting = true;
+
   } else {
 
+    // caught up after backing up
+    if (reprinting) {
+      print_cache_stats();
+      reprinting = false;
+    }
+
     double x = DigitsOfPi(digit_num);
     double y = x * 1.0e9;
     int digit = int32_t(y) / 100000000;
 
     digit_char = '0' + digit;
 
+    digit_cache.put(digit_num, digit_char, Time::now() - digit_start_time);
+#if TELEMETRY
+    telemetry.digit(digit_num, Time::now() - digit_start_time);
+#endif
+
   }
 
   // how long it took to calculate this digit (only used for serial prints)
@@ -409,7 +752,11 @@ void loop()
   if (!paper_wait())
     return;
 
-  print_digit(digit_char);
+  if (!print_digit(digit_char))
+    return;
   digit_num++;
 
+  checkpoint_maybe();
+  telemetry_maybe();
+
 } // loop
@@ -50,7 +50,8 @@ void emit(int digit)
     ms_to_hms(millis() - start_ms, h, m, s);
 
     char buf[50];
-    sprintf(buf, "%-18lu%d%13lu:%02lu:%02lu", digNum, digit, h, m, s);
+    sprintf(buf, "%-18lu%d%13lu:%02lu:%02lu", (unsigned long)digNum, digit,
+            (unsigned long)h, (unsigned long)m, (unsigned long)s);
     Serial.print(buf);
 
     if (err)
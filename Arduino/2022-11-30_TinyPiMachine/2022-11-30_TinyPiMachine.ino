@@ -5,9 +5,10 @@
 
 #include <Arduino.h>
 #include <string.h>
-#include <stdio.h>
+#include <line_format.h>
 #include <printer.h>
 #include <tiny_pi_machine.h>
+#include <heat_control.h>
 #include "pi.h"
 
 // if 1, wait for serial (usb) console before starting
@@ -16,22 +17,47 @@
 // if 1, print to real printer in addition to console
 #define USE_PRINTER 1
 
-// Minimum number of milliseconds per digit printed.
-// 250 seems to be about the fastest, slower for effect (or debugging).
-static const uint32_t print_interval_ms = 500;
-
-// Below this, print recharge message and stop.
-// See comments at printer.heat() call in setup().
+// Printer heat settings and milliseconds per digit printed, fastest first.
+// heat_control moves along these as the battery allows (see heat_control.h).
+// (5, 200, 1) at 500 msec is what this used to always use.
+static const HeatProfile heat_profiles[] = {
+  { 9, 200, 1,  300 },
+  { 7, 200, 1,  400 },
+  { 5, 200, 1,  500 },
+  { 3, 200, 2,  600 },
+  { 2, 200, 4,  750 },
+  { 1, 200, 8, 1000 },
+};
+static const int heat_profiles_num = sizeof(heat_profiles) / sizeof(heat_profiles[0]);
+static const int heat_profile_start = 2;
+
+// The battery shouldn't be seen lower than this while printing. The
+// protection cutoff is somewhere below; the drain test with (5, 200, 1)
+// has the battery reading around 3.6 V (between lines) when it hits it.
+// This one has only been tried in the simulator, not measured.
+static const int battery_floor_mv = 3300;
+
+static HeatControl heat_control(heat_profiles, heat_profiles_num,
+                                heat_profile_start, battery_floor_mv);
+
+// Below this at power on, print recharge message and stop. This leaves room
+// for the sag with (5, 200, 1). With heat_control watching the sag it could
+// probably be lower, but not until that's been measured on the hardware.
 static const uint32_t battery_min_mv = 3800;
 
 static Printer printer(Serial1);
 
 static int32_t digit_num = 0;
 
-// for snprintf
+// for messages
 static const int pbuf_len = 40;
 static char pbuf[pbuf_len];
 
+// Boot timing (millis() counts from reset, i.e. the button press). Printed
+// on the console after the first digit.
+static uint32_t printer_ready_ms = 0;
+static uint32_t first_digit_ms = 0;
+
 
 // Check button each call. When it has been seen released for btn_timeout_ms,
 // print some lines, delay, then power off (never returns in that case).
@@ -64,17 +90,34 @@ static void check_button()
 }
 
 
-// Check battery. Called once at startup. If battery is below battery_min_mv,
-// print a message and power off.
-static void check_battery()
+// Battery voltage in mV.
+static int read_battery()
 {
   int adc = analogRead(adc_batt);
-  int mv = (adc * 625L + 64) / 128; // 64 is for rounding
+  return (adc * 625L + 64) / 128; // 64 is for rounding
+}
+
+
+// "<before><mv><after>" into buf
+static void battery_message(char *buf, const char *before, int mv,
+                            const char *after)
+{
+  using namespace line_format;
+  char *b = text(buf, before);
+  b = decimal(b, mv);
+  b = text(b, after);
+  *b = '\0';
+}
 
+
+// Check battery. Called once at startup. If battery is below battery_min_mv,
+// print a message and power off.
+static void check_battery(int mv)
+{
   if (mv >= battery_min_mv) {
 
 #if 0
-    snprintf(pbuf, pbuf_len-1, "Battery: %d mV", mv); // 23 chars max
+    battery_message(pbuf, "Battery: ", mv, " mV"); // 23 chars max
     Serial.println(pbuf);
 #if USE_PRINTER
     printer.print(pbuf);
@@ -84,9 +127,15 @@ static void check_battery()
     return;
   }
 
-  // does not return
+  charge_battery(mv); // does not return
 
-  snprintf(pbuf, pbuf_len-1, "CHARGE BATTERY (%d mV)", mv); // 31 chars max
+} // check_battery
+
+
+// Print recharge message and power off (never returns).
+static void charge_battery(int mv)
+{
+  battery_message(pbuf, "CHARGE BATTERY (", mv, " mV)"); // 31 chars max
 
   Serial.println(pbuf);
 
@@ -103,7 +152,85 @@ static void check_battery()
     delay(1);
   }
 
-} // check_battery
+} // charge_battery
+
+
+// Use the printer heat settings heat_control says to.
+static void set_heat()
+{
+  const HeatProfile& p = heat_control.profile();
+#if USE_PRINTER
+  printer.heat(p.dots, p.time, p.interval);
+#endif
+}
+
+
+// After each line: apply what heat_control makes of the battery readings
+// taken while it printed, and say so on the console if anything changed.
+// Doesn't return if the battery is done.
+static void check_heat()
+{
+  HeatControl::Change change = heat_control.line_done();
+  if (change == HeatControl::Same)
+    return;
+
+  if (change == HeatControl::Stop)
+    charge_battery(heat_control.rest_mv); // does not return
+
+  const HeatProfile& p = heat_control.profile();
+  Serial.print("heat: ");
+  Serial.print(change == HeatControl::Faster ? "faster " : "slower ");
+  Serial.print(p.dots);
+  Serial.print(',');
+  Serial.print(p.time);
+  Serial.print(',');
+  Serial.print(p.interval);
+  Serial.print(' ');
+  Serial.print(p.line_ms);
+  Serial.print(" ms (battery ");
+  Serial.print(heat_control.rest_mv);
+  Serial.print(" mV, ");
+  Serial.print(heat_control.low_mv);
+  Serial.print(" mV printing, line ");
+  Serial.print(digit_num);
+  Serial.println(")");
+
+  set_heat();
+}
+
+
+// The text parts of a digit's line
+struct Line {
+
+  char console[line_format::console_head_len];
+  char number[line_format::num_len];
+  char digit;
+
+  void format(char d, int32_t num)
+  {
+    digit = d;
+
+    // only print number if digit is 0..9
+    line_format::console_head(console, num, digit); // 18 chars
+
+    // digit number
+    line_format::number(number, num, digit); // 12 chars
+  }
+
+};
+
+
+// The first two lines ('3' and '.') are formatted while the printer boots.
+static const int num_first_lines = 2;
+static Line first_lines[num_first_lines];
+static int first_line = 0;
+
+
+static void format_first_line(int i)
+{
+  // loop() prints the '3', then the '.'
+  first_lines[i].format(i == 0 ? char(pgm_read_byte(pi)) : '.', 0);
+}
 
 
 // print a digit
@@ -114,12 +241,26 @@ static void print_digit(char digit)
   // Limit print rate so we don't queue up lines in the receive buffer,
   // which breaks paper-out handling. This is different from worrying
   // about overrunning the receive buffer; we basically want to know a
-  // digit is on the paper before we try to print another one.
-  static uint32_t last_print_ms = millis();
-  while ((millis() - last_print_ms) < print_interval_ms)
+  // digit is on the paper before we try to print another one. The first
+  // digit doesn't wait. Meanwhile, watch the battery sag (while the line
+  // prints) and recover.
+  static bool printed = false;
+  static uint32_t last_print_ms;
+  while (printed && (millis() - last_print_ms) < heat_control.profile().line_ms) {
+    heat_control.sample(read_battery());
     delay(1);
+  }
+  if (printed)
+    check_heat();
   last_print_ms = millis();
 
+  Line line;
+  const Line *l = &line;
+  if (first_line < num_first_lines && first_lines[first_line].digit == digit)
+    l = &first_lines[first_line++];
+  else
+    line.format(digit, digit_num);
+
   // large font is 12 pixels wide x 24 pixels high
 
   // rotated and doubled digit is 48 pixels wide
@@ -134,27 +275,13 @@ static void print_digit(char digit)
   // nothing:      12 chars @ 12 pixels = 144 pixels
   // total:                               384 pixels
 
-  // only print number if digit is 0..9
-  if ('0' <= digit && digit <= '9')
-    snprintf(pbuf, pbuf_len-1, "%-12ld| %c |", digit_num, digit); // 18 chars
-  else
-    snprintf(pbuf, pbuf_len-1, "            | %c |", digit); // 18 chars
-  pbuf[pbuf_len-1] = '\0';
-
-  Serial.println(pbuf);
+  Serial.println(l->console);
 
 #if USE_PRINTER
 
-  // digit number
-  if ('0' <= digit && digit <= '9')
-    snprintf(pbuf, pbuf_len-1, "%-12ld", digit_num); // 13 chars
-  else
-    strncpy(pbuf, "            ", pbuf_len-1); // 13 chars
-  pbuf[pbuf_len-1] = '\0';
-
   printer.rotate(false);
   printer.mode(Printer::Modes::FontLarge);
-  printer.print(pbuf);
+  printer.print(l->number);
   printer.print(0xb2); // gray box
   printer.print(' ');
 
@@ -176,9 +303,92 @@ static void print_digit(char digit)
 
 #endif // USE_PRINTER
 
+  if (!printed) {
+    printed = true;
+    first_digit_ms = millis();
+    Serial.print("first digit at ");
+    Serial.print(first_digit_ms);
+    Serial.print(" ms (printer ready at ");
+    Serial.print(printer_ready_ms);
+    Serial.println(" ms)");
+  }
+
 } // print_digit
 
 
+// Boot: get to the first digit as soon as the printer will take it.
+//
+// The printer powers up along with everything else when the button is
+// pressed, and ignores what it's sent until it has booted. Rather than
+// sleeping long enough for that, keep asking for its status until it
+// answers (a few msec once it's up), and reset it now and then in case it
+// came up in the middle of something it was sent. Meanwhile, format the
+// first lines. If it never answers (no RX wire?), go ahead after give_up_ms
+// like before.
+//
+// Returns the battery voltage, read once the printer is up: the reset
+// is when the printer pulls the most and the battery sags the most, so a
+// reading during the wait would look low.
+static int boot()
+{
+  const uint32_t probe_ms = 20;     // answer is < 10 msec once it's up
+  const uint32_t reset_ms = 500;
+  const uint32_t give_up_ms = 1000;
+
+  enum class State { Reset, Request, Probe, Ready } state = State::Reset;
+
+  uint32_t reset_start_ms = 0;
+  uint32_t probe_start_ms = 0;
+  int formatted = 0;
+
+  while (state != State::Ready) {
+
+    switch (state) {
+
+      case State::Reset:
+        // reset, then immediately status is okay (see printer.cpp)
+        printer.reset();
+        reset_start_ms = millis();
+        state = State::Request;
+        break;
+
+      case State::Request:
+        printer.status_request(1);
+        probe_start_ms = millis();
+        state = State::Probe;
+        break;
+
+      case State::Probe:
+        if (printer.status_response() != -1 || millis() >= give_up_ms)
+          state = State::Ready;
+        else if ((millis() - reset_start_ms) >= reset_ms)
+          state = State::Reset;
+        else if ((millis() - probe_start_ms) >= probe_ms)
+          state = State::Request;
+        break;
+
+      case State::Ready:
+        break;
+    }
+
+    // other things to do while waiting, one per pass
+    if (formatted < num_first_lines)
+      format_first_line(formatted++);
+  }
+
+  int mv = read_battery();
+
+  // in case the printer came up so fast there wasn't time
+  while (formatted < num_first_lines)
+    format_first_line(formatted++);
+
+  printer_ready_ms = millis();
+
+  return mv;
+
+} // boot
+
+
 void setup()
 {
   Serial.begin(115200);
@@ -196,9 +406,10 @@ void setup()
 #endif
 
   // printer.begin() sets the baud rate and sends a reset command,
-  // but does not wait for any responses from the printer
+  // but does not wait for any responses from the printer; boot() waits
+  // for it to answer
   printer.begin(printer_baud);
-  delay(500);
+  int mv = boot();
 
   // This intertwines with the minimum allowed battery voltage. The more
   // current the printer pulls, the higher the threshold has to be. When the
@@ -206,9 +417,10 @@ void setup()
   // the battery) and can hit the battery protection cutoff. With (5, 200, 1),
   // the drain test program works to around a measured voltage of 3.6 V.
   // Presumably, as the battery ages, the IR (and drop) will be greater.
-  printer.heat(5, 200, 1);
+  // heat_control starts there and adjusts as it goes.
+  set_heat();
 
-  check_battery(); // doesn't return if battery too low
+  check_battery(mv); // doesn't return if battery too low
 
 } // setup
 
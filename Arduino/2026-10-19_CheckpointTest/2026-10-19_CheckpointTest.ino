@@ -0,0 +1,244 @@
+// CheckpointTest
+
+// Cut the power to a checkpoint store over and over, at random points in
+// its saves and erases, and check that every time it comes back up it
+// loads the newest checkpoint that was completely written (or the one that
+// was being written, if the cut came just after it was done).
+//
+// The flash is a RAM stand-in, a few sectors, so the ring goes around many
+// times. A cut stops a program or erase partway (a byte at a time), and
+// everything after it fails until the "power" comes back.
+
+#include <Arduino.h>
+#include <string.h>
+#include <checkpoint.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+// power cuts to make
+static const int num_cuts = 20000;
+
+static int failures = 0;
+
+
+static void result(bool pass, const char* msg)
+{
+  if (pass)
+    Serial.print("PASS: ");
+  else
+    Serial.print("FAIL: ");
+  Serial.println(msg);
+}
+
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand32()
+{
+  // xorshift32
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+
+// NOR flash in RAM that loses power after 'budget' more bytes are programmed
+// or erased (-1: never)
+class RamFlash : public FlashDev {
+
+  public:
+
+    static const uint32_t sector = 4096;
+    static const uint32_t size = 4 * sector;
+
+    int32_t budget;
+
+    RamFlash() : budget(-1) { memset(_mem, 0xff, sizeof(_mem)); }
+
+    virtual uint32_t sector_size() { return sector; }
+
+    virtual bool read(uint32_t addr, void *buf, uint32_t len)
+    {
+      if (addr + len > size)
+        return false;
+      memcpy(buf, _mem + addr, len);
+      return true;
+    }
+
+    virtual bool program(uint32_t addr, const void *buf, uint32_t len)
+    {
+      if (addr + len > size)
+        return false;
+      const uint8_t *b = (const uint8_t *)buf;
+      for (uint32_t i = 0; i < len; i++) {
+        if (!spend())
+          return false;
+        _mem[addr + i] &= b[i];
+      }
+      return true;
+    }
+
+    virtual bool erase(uint32_t addr)
+    {
+      if (addr >= size)
+        return false;
+      addr -= addr % sector;
+      for (uint32_t i = 0; i < sector; i++) {
+        if (!spend())
+          return false;
+        _mem[addr + i] = 0xff;
+      }
+      return true;
+    }
+
+  private:
+
+    uint8_t _mem[size];
+
+    bool spend()
+    {
+      if (budget == 0)
+        return false;
+      if (budget > 0)
+        budget--;
+      return true;
+    }
+};
+
+static RamFlash flash;
+
+
+// what gets saved: a counter, and the rest filled in from it so a torn
+// write shows up even if the CRC were to miss it
+struct Payload {
+  int32_t count;
+  uint8_t fill[60];
+
+  void make(int32_t c)
+  {
+    count = c;
+    for (unsigned i = 0; i < sizeof(fill); i++)
+      fill[i] = uint8_t(c * 31 + i);
+  }
+
+  bool intact() const
+  {
+    Payload q;
+    q.make(count);
+    return memcmp(this, &q, sizeof(q)) == 0;
+  }
+};
+
+
+static void cuts()
+{
+  int32_t newest = -1;      // last count known to be saved
+  int32_t cut = -1;         // count being saved when the power went
+  uint32_t saves = 0, erases = 0, cut_saves = 0;
+  int fail0 = failures;
+
+  for (int i = 0; i <= num_cuts; i++) {
+
+    // power on
+    CheckpointStore store(flash);
+    if (!store.begin(0, RamFlash::size)) {
+      result(false, "begin");
+      return;
+    }
+    Payload p;
+    uint16_t len = store.load(&p, sizeof(p));
+
+    bool ok;
+    if (newest < 0 && cut < 0)
+      ok = (len == 0);
+    else
+      ok = len == sizeof(p) && p.intact() && (p.count == newest || p.count == cut);
+    if (!ok) {
+      failures++;
+      if (failures - fail0 <= 5) {
+        Serial.print("  cut ");
+        Serial.print(i);
+        Serial.print(": want ");
+        Serial.print(newest);
+        Serial.print(" (or ");
+        Serial.print(cut);
+        Serial.print("), got ");
+        if (len == sizeof(p))
+          Serial.print(p.count);
+        else
+          Serial.print("nothing");
+        Serial.println();
+      }
+    }
+    if (len == sizeof(p))
+      newest = p.count;
+    cut = -1;
+
+    if (i == num_cuts)
+      break;
+
+    // a few saves, then one that the power goes out during: somewhere in
+    // its program (a slot), or in its erase if it has one
+    int n = int(rand32() % 5);
+    for (int j = 0; j < n; j++) {
+      p.make(newest + 1);
+      if (store.save(&p, sizeof(p)))
+        newest = p.count;
+    }
+    if (rand32() % 2 == 0)
+      flash.budget = int32_t(rand32() % CheckpointStore::slot_size);
+    else
+      flash.budget = int32_t(rand32() % (RamFlash::sector + CheckpointStore::slot_size));
+    cut = newest + 1;
+    p.make(cut);
+    if (store.save(&p, sizeof(p))) {
+      // (it got done first)
+      newest = cut;
+      cut = -1;
+      cut_saves++;
+    }
+    flash.budget = -1;
+
+    saves += store.saves;
+    erases += store.erases;
+  }
+
+  Serial.print("  ");
+  Serial.print(num_cuts);
+  Serial.print(" cuts, ");
+  Serial.print(saves);
+  Serial.print(" saves, ");
+  Serial.print(erases);
+  Serial.print(" erases (");
+  Serial.print(erases / (RamFlash::size / RamFlash::sector));
+  Serial.print(" times around), ");
+  Serial.print(cut_saves);
+  Serial.println(" finished just before the cut");
+  result(failures == fail0, "newest complete checkpoint after every cut");
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("CheckpointTest");
+
+  cuts();
+
+  Serial.println(failures == 0 ? "all passed" : "FAILED");
+
+} // setup
+
+
+void loop()
+{
+}
@@ -0,0 +1,279 @@
+// LineFormatTest
+
+// Check that line_format writes what the snprintf formats it replaced
+// did, for values at every width boundary and a lot of random ones (and the
+// same with a '-' for negative times, which those dropped), then time a
+// line each way.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono.h>
+#include <line_format.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+// lines to time each way
+static const int time_lines = 2000;
+
+static int failures = 0;
+
+
+static void result(bool pass, const char* msg)
+{
+  if (pass)
+    Serial.print("PASS: ");
+  else
+    Serial.print("FAIL: ");
+  Serial.println(msg);
+}
+
+
+// the old way (digit_sink.cpp)
+
+static int old_console(char *buf, int size, int32_t num, char digit,
+                       int64_t elapsed_ms, int32_t compute_ms)
+{
+  uint32_t h, m, s, ms;
+  Interval(elapsed_ms).hmsm(h, m, s, ms);
+  if ('0' <= digit && digit <= '9')
+    return snprintf(buf, size, "%-12ld| %c |%6lu:%02lu:%02lu%9ld\r\n",
+                    (long)num, digit, (unsigned long)h, (unsigned long)m,
+                    (unsigned long)s, (long)compute_ms);
+  else
+    return snprintf(buf, size, "            | %c |            %9ld\r\n",
+                    digit, (long)compute_ms);
+}
+
+
+static void old_printer(char *num_buf, char *time_buf, int size, int32_t num,
+                        char digit, int64_t elapsed_ms)
+{
+  uint32_t h, m, s, ms;
+  Interval(elapsed_ms).hmsm(h, m, s, ms);
+  if ('0' <= digit && digit <= '9')
+    snprintf(num_buf, size, "%-12ld", (long)num);
+  else
+    strcpy(num_buf, "            ");
+  snprintf(time_buf, size, "%6lu:%02lu:%02lu", (unsigned long)h,
+           (unsigned long)m, (unsigned long)s);
+}
+
+
+// one line both ways; false (and says so) if they differ
+static bool same(int32_t num, char digit, int64_t elapsed_ms, int32_t compute_ms)
+{
+  char want[80], got[line_format::console_len];
+  int want_len = old_console(want, sizeof(want), num, digit, elapsed_ms,
+                             compute_ms);
+  int got_len = line_format::console_line(got, num, digit, elapsed_ms,
+                                          compute_ms);
+  bool ok = want_len == got_len && strcmp(want, got) == 0;
+
+  char want_num[40], want_time[40];
+  char got_num[line_format::num_len], got_time[line_format::time_len];
+  old_printer(want_num, want_time, sizeof(want_num), num, digit, elapsed_ms);
+  line_format::number(got_num, num, digit);
+  line_format::timestamp(got_time, elapsed_ms);
+  ok = ok && strcmp(want_num, got_num) == 0 && strcmp(want_time, got_time) == 0;
+
+  // the Tiny's console line is this one up to the second '|'
+  char want_head[40], got_head[line_format::console_head_len];
+  line_format::console_head(got_head, num, digit);
+  const char *bar = strchr(strchr(want, '|') + 1, '|');
+  int head_len = int(bar - want) + 1;
+  memcpy(want_head, want, head_len);
+  want_head[head_len] = '\0';
+  ok = ok && strcmp(want_head, got_head) == 0;
+
+  if (!ok) {
+    Serial.print("  want: ");
+    Serial.print(want);
+    Serial.print("  got:  ");
+    Serial.print(got);
+    failures++;
+  }
+  return ok;
+}
+
+
+// A negative time is the positive one with a '-' before the hours (the old
+// formats left it off). s is a line or a timestamp with the timestamp
+// starting at 'at'; the result goes in out.
+static void with_minus(char *out, const char *s, int at)
+{
+  int h = at;
+  while (s[h] == ' ')
+    h++;
+  if (h > at) {
+    strcpy(out, s);
+    out[h - 1] = '-';
+  } else {
+    memcpy(out, s, at);
+    out[at] = '-';
+    strcpy(out + at + 1, s + at);
+  }
+}
+
+
+// -elapsed_ms (elapsed_ms > 0) against the old way's elapsed_ms
+static bool negative(int64_t elapsed_ms)
+{
+  const int32_t num = 314159;
+  const int32_t compute_ms = 2718;
+  const int time_at = line_format::num_width + 5;
+
+  char old[80], want[80], got[line_format::console_len];
+  old_console(old, sizeof(old), num, '7', elapsed_ms, compute_ms);
+  with_minus(want, old, time_at);
+  line_format::console_line(got, num, '7', -elapsed_ms, compute_ms);
+  bool ok = strcmp(want, got) == 0;
+
+  char old_num[40], old_time[40], want_time[41];
+  char got_time[line_format::time_len];
+  old_printer(old_num, old_time, sizeof(old_time), num, '7', elapsed_ms);
+  with_minus(want_time, old_time, 0);
+  line_format::timestamp(got_time, -elapsed_ms);
+  ok = ok && strcmp(want_time, got_time) == 0;
+
+  if (!ok) {
+    Serial.print("  want: ");
+    Serial.print(want);
+    Serial.print("  got:  ");
+    Serial.print(got);
+    failures++;
+  }
+  return ok;
+}
+
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand32()
+{
+  // xorshift32
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+
+static void check()
+{
+  static const int32_t nums[] = {
+    0, 1, 9, 10, 99, 100, 12345, 99999999, 100000000, 999999999, 1000000000,
+    2147483647, -1, -2147483647 - 1,
+  };
+  static const int64_t times[] = {
+    0, 1, 999, 1000, 59999, 60000, 3599999, 3600000, 86399999,
+    359999999, 360000000, 4294967295LL, 4294967296LL, 4294968295LL,
+    3599999999999LL,    // 999999:59:59
+    3600000000000LL,    // 1000000 hours (114 years)
+    4294967295999LL,    // 1193046:28:15, as far as it goes (136 years)
+  };
+  static const int32_t computes[] = {
+    0, 1, 12345, 99999999, 999999999, 1000000000, 2147483647, -1,
+    -2147483647 - 1,
+  };
+
+  int fail0 = failures;
+  for (int32_t n : nums)
+    for (int64_t t : times)
+      for (int32_t c : computes)
+        same(n, '7', t, c);
+  result(failures == fail0, "widths");
+
+  fail0 = failures;
+  for (int64_t t : times)
+    for (int32_t c : computes)
+      same(12, '.', t, c);
+  result(failures == fail0, "not a digit");
+
+  fail0 = failures;
+  for (int64_t t : times)
+    if (t > 0)
+      negative(t);
+  result(failures == fail0, "negative time");
+
+  fail0 = failures;
+  for (int i = 0; i < 100000 && failures - fail0 < 5; i++) {
+    int32_t n = int32_t(rand32() >> (rand32() % 32));
+    uint64_t u = ((uint64_t(rand32()) << 32) | rand32()) >> (rand32() % 64);
+    int64_t t = int64_t(u % 4294967296000ULL);
+    int32_t c = int32_t(rand32() >> (rand32() % 32));
+    same(n, char('0' + rand32() % 10), t, c);
+  }
+  result(failures == fail0, "random");
+}
+
+
+// average usec per line, old way or new
+static float time_lines_us(bool old)
+{
+  char buf[80], num_buf[40], time_buf[40];
+  int32_t num = 123456;
+  int64_t ms = 987654321LL;
+  uint32_t sum = 0;
+  uint32_t start = micros();
+  for (int i = 0; i < time_lines; i++) {
+    if (old) {
+      sum += old_console(buf, sizeof(buf), num + i, '5', ms + i * 613, 61234);
+      old_printer(num_buf, time_buf, sizeof(num_buf), num + i, '5', ms + i * 613);
+    } else {
+      sum += line_format::console_line(buf, num + i, '5', ms + i * 613, 61234);
+      line_format::number(num_buf, num + i, '5');
+      line_format::timestamp(time_buf, ms + i * 613);
+    }
+    sum += num_buf[0] + time_buf[0];
+  }
+  uint32_t us = micros() - start;
+  if (sum == 0)
+    Serial.print(""); // (keep the loop)
+  return float(us) / time_lines;
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("LineFormatTest");
+
+  check();
+
+  // a console line and the printer's two fields, each way
+  float old_us = time_lines_us(true);
+  float new_us = time_lines_us(false);
+  Serial.print("snprintf:    ");
+  Serial.print(old_us, 2);
+  Serial.print(" us per line");
+#ifdef F_CPU
+  Serial.print(", ");
+  Serial.print(long(old_us * (F_CPU / 1000000)));
+  Serial.print(" cycles");
+#endif
+  Serial.println();
+  Serial.print("line_format: ");
+  Serial.print(new_us, 2);
+  Serial.print(" us per line");
+#ifdef F_CPU
+  Serial.print(", ");
+  Serial.print(long(new_us * (F_CPU / 1000000)));
+  Serial.print(" cycles");
+#endif
+  Serial.println();
+
+} // setup
+
+
+void loop()
+{
+}
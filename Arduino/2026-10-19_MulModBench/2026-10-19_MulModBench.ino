@@ -0,0 +1,133 @@
+// MulModBench
+
+// Time each of the modular arithmetic kernels (mulmod.h) on this CPU: a
+// chain of dependent multiplies with a modulus near the top of each one's
+// range, then DigitsOfPi itself with every modulus forced into each (the
+// 48-bit one is what DigitsOfPi used for everything before there were
+// three).
+
+#include <Arduino.h>
+#include <pidec.h>
+#include <mulmod.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+// multiplies to time per kernel
+static const long chain_len = 200000;
+
+// n to time DigitsOfPi at
+static const long pi_n[] = { 300, 1000, 3000 };
+static const int num_pi_n = sizeof(pi_n) / sizeof(pi_n[0]);
+
+// keep repeating a measurement until it adds up to at least this long
+static const uint32_t min_measure_us = 200000;
+
+static const int widths[] = { 0, 48, 63 };
+static const int num_widths = sizeof(widths) / sizeof(widths[0]);
+
+
+static void print_us(double us, const char *what)
+{
+  Serial.print(us, 3);
+  Serial.print(" us");
+#ifdef F_CPU
+  Serial.print(" (");
+  Serial.print(long(us * (F_CPU / 1000000) + 0.5));
+  Serial.print(" cycles)");
+#endif
+  Serial.print(" per ");
+  Serial.println(what);
+}
+
+
+// usec per multiply, and the result so it isn't optimized away (a class,
+// since sketch prototypes don't do function templates)
+template <class K>
+struct Chain {
+  static double us(int64_t m, int64_t& r)
+  {
+    const K md(m);
+    r = 3;
+    uint32_t start = micros();
+    for (long i = 0; i < chain_len; i++)
+      r = md.Mul(r, 1000003 + (i & 15));
+    uint32_t us = micros() - start;
+    return double(us) / chain_len;
+  }
+};
+
+
+// name says what m is
+static void bench_kernel(const char *name, double us, int64_t r)
+{
+  Serial.print(name);
+  Serial.print(" (r mod 1000 = ");
+  Serial.print(long(r % 1000));
+  Serial.print("): ");
+  print_us(us, "Mul");
+}
+
+
+// average usec per DigitsOfPi(n)
+static double pi_us(long n, double& x)
+{
+  uint32_t total = 0;
+  int reps = 0;
+  do {
+    uint32_t start = micros();
+    x = DigitsOfPi(n);
+    total += micros() - start;
+    reps++;
+  } while (total < min_measure_us);
+  return double(total) / reps;
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("MulModBench");
+
+  int64_t r;
+  double us = Chain<Modulus<31>>::us((int64_t(1) << 31) - 1, r);
+  bench_kernel("Modulus<31>, m=2^31-1", us, r);
+  us = Chain<Modulus<48>>::us((int64_t(1) << 48) - 59, r);
+  bench_kernel("Modulus<48>, m=2^48-59", us, r);
+  us = Chain<Modulus<63>>::us((int64_t(1) << 62) - 57, r);
+  bench_kernel("Modulus<63>, m=2^62-57", us, r);
+
+  for (int i = 0; i < num_pi_n; i++) {
+    double want = 0.;
+    for (int w = 0; w < num_widths; w++) {
+      DigitsOfPiWidth(widths[w]);
+      double x;
+      double us = pi_us(pi_n[i], x);
+      if (w == 0)
+        want = x;
+      Serial.print("n=");
+      Serial.print(pi_n[i]);
+      Serial.print(widths[w] == 0 ? " narrowest: " : widths[w] == 48 ? " 48-bit:    " : " 63-bit:    ");
+      Serial.print(us / 1000., 2);
+      Serial.print(" ms, digit ");
+      Serial.print(int(x * 10));
+      if (int(x * 10) != int(want * 10))
+        Serial.print(" MISMATCH");
+      Serial.println();
+    }
+  }
+  DigitsOfPiWidth(0);
+
+} // setup
+
+
+void loop()
+{
+}
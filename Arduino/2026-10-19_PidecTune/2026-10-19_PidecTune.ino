@@ -0,0 +1,199 @@
+// PidecTune
+
+// Measure the two stages of DigitsOfPi on this CPU, fit a cost model, and
+// print a pi_tune[] table to paste into pidec_tune.cpp.
+//
+// For a given n, with N following from M:
+//   series:   a * (M*N + N)        one PowMod per term
+//   binomial: b * N*N/4 + c * N    the j loops of SumBinomialMod (min(k, N-k)
+//                                  steps each) plus the PowMods per k
+// Timing each stage at a few values of M gives a, b, and c. Then the model
+// is evaluated for every M to find the cheapest, and that one is timed for
+// real to make sure.
+
+#include <Arduino.h>
+#include <pidec.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+// n to measure at (on an M4, the last one takes a while)
+static const long probe_n[] = { 100, 300, 1000, 3000, 10000 };
+static const int num_probes = sizeof(probe_n) / sizeof(probe_n[0]);
+
+// keep repeating a measurement until it adds up to at least this long
+static const uint32_t min_measure_us = 200000;
+
+static PiTune tuned[num_probes + 1];
+
+
+// unscaled M/2 for n
+static double m_base(long n)
+{
+  double logn = log((double)n);
+  return 3. * n / logn / logn / logn;
+}
+
+
+// average microseconds per call for each stage
+static void measure(long n, long M, double& series_us, double& binomial_us)
+{
+  uint32_t total_s = 0, total_b = 0;
+  int reps = 0;
+  do {
+    uint32_t s, b;
+    DigitsOfPi(n, M, &s, &b);
+    total_s += s;
+    total_b += b;
+    reps++;
+  } while (total_s + total_b < min_measure_us);
+  series_us = double(total_s) / reps;
+  binomial_us = double(total_b) / reps;
+}
+
+
+static double model(double a, double b, double c, long n, long M)
+{
+  double N = DigitsOfPiN(n, M);
+  return a * (M * N + N) + b * N * N / 4. + c * N;
+}
+
+
+// return the M scale factor for n
+static float tune(long n)
+{
+  const long M0 = 2 * (long)m_base(n);
+
+  const int num_m = 3;
+  long m[num_m] = { M0 / 4, M0, M0 * 4 };
+
+  // series: least squares through the origin
+  // binomial: least squares for b and c
+  double st = 0., sx = 0.;
+  double qq = 0., qN = 0., NN = 0., qt = 0., Nt = 0.;
+
+  for (int i = 0; i < num_m; i++) {
+    // M must be even and large enough that N < n
+    if (m[i] < 2)
+      m[i] = 2;
+    m[i] += m[i] % 2;
+    while (DigitsOfPiN(n, m[i]) >= n)
+      m[i] += 2;
+    double ts, tb;
+    measure(n, m[i], ts, tb);
+    double N = DigitsOfPiN(n, m[i]);
+    double x = m[i] * N + N;
+    double q = N * N / 4.;
+    st += ts * x;
+    sx += x * x;
+    qq += q * q;
+    qN += q * N;
+    NN += N * N;
+    qt += q * tb;
+    Nt += N * tb;
+  }
+
+  double a = st / sx;
+  double det = qq * NN - qN * qN;
+  double b = (qt * NN - Nt * qN) / det;
+  double c = (qq * Nt - qN * qt) / det;
+  if (b <= 0. || c < 0.) {
+    // the fit didn't work out (too small to measure well?); N*N only
+    b = qt / qq;
+    c = 0.;
+  }
+
+  long best_M = M0;
+  double best = model(a, b, c, n, M0);
+  for (long M = 2; M <= 16 * M0 + 2; M += 2) {
+    if (DigitsOfPiN(n, M) >= n)
+      continue;
+    double t = model(a, b, c, n, M);
+    if (t < best) {
+      best = t;
+      best_M = M;
+    }
+  }
+
+  // scale so that 2 * (long)(scale * m_base) == best_M
+  float scale = float((best_M / 2 + 0.5) / m_base(n));
+
+  double ts0, tb0, ts1, tb1;
+  measure(n, M0, ts0, tb0);
+  measure(n, best_M, ts1, tb1);
+
+  Serial.print("n=");
+  Serial.print(n);
+  Serial.print(" a=");
+  Serial.print(a, 4);
+  Serial.print(" b=");
+  Serial.print(b, 4);
+  Serial.print(" c=");
+  Serial.print(c, 4);
+  Serial.print(" b/a=");
+  Serial.print(b / a, 3);
+  Serial.print("  M ");
+  Serial.print(M0);
+  Serial.print(" -> ");
+  Serial.print(best_M);
+  Serial.print("  us ");
+  Serial.print(long(ts0 + tb0));
+  Serial.print(" -> ");
+  Serial.print(long(ts1 + tb1));
+  Serial.println();
+
+  // not worth it if it isn't actually faster
+  if (best_M == M0 || ts1 + tb1 >= ts0 + tb0)
+    return 1.0f;
+
+  return scale;
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("PidecTune");
+
+  // measure with the untuned M
+  static const PiTune untuned[] = { { 0, 1.0f } };
+  DigitsOfPiTune(untuned);
+
+  for (int i = 0; i < num_probes; i++) {
+    // each probe covers up to halfway (geometrically) to the next one
+    long n_max = 0x7fffffff;
+    if (i + 1 < num_probes)
+      n_max = long(sqrt(double(probe_n[i]) * double(probe_n[i + 1])));
+    tuned[i].n_max = n_max;
+    tuned[i].m_scale = tune(probe_n[i]);
+  }
+  tuned[num_probes].n_max = 0;
+  tuned[num_probes].m_scale = 1.0f;
+
+  Serial.println();
+  Serial.println("const PiTune pi_tune[] = {");
+  for (int i = 0; i <= num_probes; i++) {
+    Serial.print("  { ");
+    Serial.print(tuned[i].n_max);
+    Serial.print(", ");
+    Serial.print(tuned[i].m_scale, 3);
+    Serial.println("f },");
+  }
+  Serial.println("};");
+
+  // and use it from now on
+  DigitsOfPiTune(tuned);
+
+} // setup
+
+
+void loop()
+{
+}
@@ -0,0 +1,85 @@
+// TelemetryDump
+
+// Print the PiMachine's telemetry (telemetry.h) from the QSPI flash, as hex
+// lines for Host/pitelemetry:
+//
+//   telemetry <offset> <32 bytes in hex>
+//
+// Capture the console to a file and give that to pitelemetry. This only
+// reads the flash; load the PiMachine sketch again afterwards and it picks
+// up where it left off.
+
+#include <Arduino.h>
+#include <checkpoint.h>
+#include <qspi_flash.h>
+#include <telemetry.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+// where the PiMachine keeps it: just below its 64K of checkpoints
+static const uint32_t checkpoint_size = 64 * 1024;
+
+static QspiFlash flash;
+static Telemetry telemetry;
+
+
+static void print_hex(uint32_t v, int digits)
+{
+  static const char hex[] = "0123456789abcdef";
+  while (digits-- > 0)
+    Serial.print(hex[(v >> (4 * digits)) & 15]);
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("TelemetryDump");
+
+  if (!flash.begin()) {
+    Serial.println("no flash");
+    return;
+  }
+  uint32_t size = Telemetry::region_size(flash.sector_size());
+  if (!telemetry.begin(flash, flash.size() - checkpoint_size - size, size)) {
+    Serial.println("can't use flash");
+    return;
+  }
+  const Telemetry::Image& img = telemetry.image();
+  if (img.seq == 0) {
+    Serial.println("no telemetry saved");
+    return;
+  }
+
+  Serial.print("save ");
+  Serial.print(img.seq);
+  Serial.print(", ");
+  Serial.print((long)(img.run_ms / 3600000));
+  Serial.println(" hours running");
+
+  const uint8_t *p = (const uint8_t *)&img;
+  for (uint32_t off = 0; off < sizeof(img); off += 32) {
+    Serial.print("telemetry ");
+    print_hex(off, 4);
+    Serial.print(' ');
+    for (uint32_t i = off; i < off + 32 && i < sizeof(img); i++)
+      print_hex(p[i], 2);
+    Serial.println();
+  }
+
+  Serial.println("done");
+
+} // setup
+
+
+void loop()
+{
+}
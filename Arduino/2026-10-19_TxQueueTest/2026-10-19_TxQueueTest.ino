@@ -0,0 +1,111 @@
+// TxQueueTest
+
+// Writes bigger than the printer's TxQueue (tx_queue.h), which used to
+// wait forever for room that could never be made. The queue itself turns
+// them down right away; Printer sends them in pieces.
+//
+// It prints about 80 lines of digits on the printer (Feather M4, Serial1).
+
+#include <Arduino.h>
+#include <string.h>
+#include <chrono.h>
+#include <printer.h>
+#include <serial_dma.h>
+
+// if 1, wait for serial (usb) console before starting
+#define WAIT_CONSOLE 1
+
+static const int printer_baud = 19200;
+
+#if defined(HOST_HAL)
+static SerialDma printer_tx(Serial1);
+#else
+// Serial1 is SERCOM5 on the Feather M4
+static SerialDma printer_tx(SERCOM5, SERCOM5_DMAC_ID_TX);
+#endif
+static Printer printer(Serial1, &printer_tx);
+
+// lines of 32 characters, two and a half queues' worth
+static const int big_lines = 80;
+static const int line_len = 32;
+static char big[big_lines * line_len + 1];
+
+static int failures = 0;
+
+
+static void result(bool pass, const char* msg)
+{
+  if (pass)
+    Serial.print("PASS: ");
+  else
+    Serial.print("FAIL: ");
+  Serial.println(msg);
+  if (!pass)
+    failures++;
+}
+
+
+void setup()
+{
+  Serial.begin(115200);
+
+#if WAIT_CONSOLE
+  while (!Serial)
+    ;
+  delay(250);
+#endif
+
+  Serial.println("TxQueueTest");
+
+  printer.begin(printer_baud);
+
+  for (int i = 0; i < big_lines; i++) {
+    char *l = big + i * line_len;
+    for (int j = 0; j < line_len - 1; j++)
+      l[j] = char('0' + (i + j) % 10);
+    l[line_len - 1] = '\n';
+  }
+  big[sizeof(big) - 1] = '\0';
+  const uint32_t len = sizeof(big) - 1;
+
+  // too big for the queue: no, and at once, even given a second to wait
+  {
+    uint32_t ticket = printer_tx.ticket();
+    uint32_t start = millis();
+    bool queued = printer_tx.queue(big, TxQueue::size + 1,
+                                   Time::now() + Interval(1000));
+    uint32_t took = millis() - start;
+    result(!queued && printer_tx.ticket() == ticket && took < 10,
+           "queue() turns down more than size bytes");
+  }
+
+  // through the printer, in pieces: all of it goes, and in about the time
+  // the UART takes (10 bits a byte)
+  {
+    printer_tx.flush(Time::now() + Interval(1000));
+    uint32_t ticket = printer.ticket();
+    uint32_t start = millis();
+    printer.print(big);
+    result(printer.ticket() - ticket == len, "print() queued all of it");
+
+    const uint32_t wire_ms = len * 10 * 1000 / printer_baud;
+    printer_tx.flush(Time::now() + Interval(2 * wire_ms + 1000));
+    uint32_t took = millis() - start;
+    Serial.print("  ");
+    Serial.print(len);
+    Serial.print(" bytes in ");
+    Serial.print(took);
+    Serial.print(" ms (");
+    Serial.print(wire_ms);
+    Serial.println(" ms on the wire)");
+    result(printer.sent() && took < 2 * wire_ms + 100, "and sent it");
+  }
+
+  Serial.println(failures == 0 ? "all passed" : "FAILED");
+
+} // setup
+
+
+void loop()
+{
+}
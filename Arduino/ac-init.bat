@@ -63,3 +63,14 @@ arduino-cli core install --no-overwrite teensy:avr ^
     --config-file .\config.yaml
 echo set FQBN=teensy:avr:teensy40 > ac-teensy.bat
 :skip_teensy_avr
+
+::::: Install Libraries
+
+:: QSPI flash, for checkpoints (2022-11-17_PiMachine)
+arduino-cli lib install "Adafruit SPIFlash" ^
+    --config-file .\config.yaml
+
+:: DMA, for the printer transport (2022-11-17_PiMachine); the Adafruit SAMD
+:: core comes with a copy, but not every version of it
+arduino-cli lib install "Adafruit Zero DMA Library" ^
+    --config-file .\config.yaml
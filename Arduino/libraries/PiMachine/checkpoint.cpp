@@ -0,0 +1,193 @@
+#include <Arduino.h>
+#include <string.h>
+#include "checkpoint.h"
+
+namespace {
+
+const uint32_t magic = 0x50694350; // "PiCP"
+
+struct Header {
+  uint32_t magic;
+  uint32_t seq;
+  uint16_t len;
+  uint16_t reserved;
+  uint32_t crc;     // of seq, len, and the data
+};
+
+static_assert(sizeof(Header) == CheckpointStore::slot_size - CheckpointStore::max_len,
+              "header size");
+
+uint32_t header_crc(const Header& h, const void *data)
+{
+  uint32_t crc = crc32(0, &h.seq, sizeof(h.seq));
+  crc = crc32(crc, &h.len, sizeof(h.len));
+  return crc32(crc, data, h.len);
+}
+
+} // namespace
+
+
+uint32_t crc32(uint32_t crc, const void *buf, uint32_t len)
+{
+  const uint8_t *p = (const uint8_t *)buf;
+  crc = ~crc;
+  while (len-- > 0) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++)
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+
+CheckpointStore::CheckpointStore(FlashDev& dev) :
+  saves(0),
+  erases(0),
+  failures(0),
+  _dev(dev),
+  _base(0),
+  _size(0),
+  _ok(false),
+  _seq(0),
+  _slot(0),
+  _next(0)
+{
+}
+
+
+bool CheckpointStore::begin(uint32_t base, uint32_t size)
+{
+  _base = base;
+  _size = size;
+  _ok = false;
+  _seq = 0;
+  _slot = 0;
+  _next = 0;
+
+  uint32_t sector = _dev.sector_size();
+  if (sector < slot_size || sector % slot_size != 0 || _size < 2 * sector ||
+      _base % sector != 0 || _size % sector != 0)
+    return false;
+
+  for (uint32_t slot = 0; slot < slots(); slot++) {
+    uint32_t seq;
+    if (check(slot, seq) && seq > _seq) {
+      _seq = seq;
+      _slot = slot;
+    }
+  }
+
+  if (_seq != 0)
+    _next = (_slot + 1) % slots();
+
+  _ok = true;
+  return true;
+}
+
+
+uint16_t CheckpointStore::load(void *buf, uint16_t max)
+{
+  if (!_ok || _seq == 0)
+    return 0;
+
+  Header h;
+  if (!_dev.read(addr(_slot), &h, sizeof(h)))
+    return 0;
+
+  uint16_t len = h.len < max ? h.len : max;
+  if (!_dev.read(addr(_slot) + sizeof(h), buf, len))
+    return 0;
+
+  return len;
+}
+
+
+bool CheckpointStore::save(const void *buf, uint16_t len)
+{
+  if (!_ok || len > max_len) {
+    failures++;
+    return false;
+  }
+
+  uint8_t page[slot_size];
+  memset(page, 0xff, sizeof(page));
+  Header h;
+  h.magic = magic;
+  h.seq = _seq + 1;
+  h.len = len;
+  h.reserved = 0xffff;
+  h.crc = header_crc(h, buf);
+  memcpy(page, &h, sizeof(h));
+  memcpy(page + sizeof(h), buf, len);
+
+  const uint32_t sector = _dev.sector_size();
+
+  // Normally the first slot tried is blank (or starts a sector), but a save
+  // cut short leaves junk behind; skip over that.
+  for (uint32_t tries = 0; tries < slots(); tries++) {
+
+    uint32_t slot = _next;
+    _next = (_next + 1) % slots();
+
+    if (addr(slot) % sector == 0) {
+      // never erase the sector with the newest checkpoint
+      if (_seq != 0 && addr(slot) / sector == addr(_slot) / sector)
+        continue;
+      if (!_dev.erase(addr(slot))) {
+        failures++;
+        continue;
+      }
+      erases++;
+    } else if (!blank(slot)) {
+      continue;
+    }
+
+    uint32_t seq;
+    if (_dev.program(addr(slot), page, slot_size) && check(slot, seq) &&
+        seq == h.seq) {
+      _seq = seq;
+      _slot = slot;
+      saves++;
+      return true;
+    }
+
+    failures++;
+  }
+
+  return false;
+}
+
+
+bool CheckpointStore::check(uint32_t slot, uint32_t& seq)
+{
+  Header h;
+  if (!_dev.read(addr(slot), &h, sizeof(h)))
+    return false;
+
+  if (h.magic != magic || h.len > max_len || h.seq == 0 || h.seq == 0xffffffff)
+    return false;
+
+  uint8_t data[max_len];
+  if (!_dev.read(addr(slot) + sizeof(h), data, h.len))
+    return false;
+
+  if (header_crc(h, data) != h.crc)
+    return false;
+
+  seq = h.seq;
+  return true;
+}
+
+
+bool CheckpointStore::blank(uint32_t slot)
+{
+  uint8_t buf[32];
+  for (uint32_t off = 0; off < slot_size; off += sizeof(buf)) {
+    if (!_dev.read(addr(slot) + off, buf, sizeof(buf)))
+      return false;
+    for (uint32_t i = 0; i < sizeof(buf); i++)
+      if (buf[i] != 0xff)
+        return false;
+  }
+  return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Raw NOR flash: erasing a sector sets it to all ones, programming can only
+// clear bits. Addresses are bytes from the start of the device.
+class FlashDev {
+
+  public:
+
+    virtual uint32_t sector_size() = 0;
+
+    virtual bool read(uint32_t addr, void *buf, uint32_t len) = 0;
+
+    virtual bool program(uint32_t addr, const void *buf, uint32_t len) = 0;
+
+    // erase the sector containing addr
+    virtual bool erase(uint32_t addr) = 0;
+
+};
+
+
+// CRC-32 (the zlib one) of len bytes, continuing from crc (0 to start)
+uint32_t crc32(uint32_t crc, const void *buf, uint32_t len);
+
+
+// Checkpoints in a region of flash that survive losing power at any point.
+//
+// The region is a ring of fixed-size slots, each holding one checkpoint
+// (header with a sequence number and CRC, then the caller's bytes). Each save
+// goes in the next slot, so wear is spread over the whole region. A sector is
+// erased just before the ring moves into it; the newest checkpoint is always
+// in the previous sector, so it survives an erase that is cut short. A save
+// that is cut short fails its CRC and the one before it is used.
+//
+// begin() scans the headers to find the newest valid checkpoint. With the
+// default 64K region that is 256 slots, a few milliseconds of reading.
+class CheckpointStore {
+
+  public:
+
+    // One slot is one flash page, so a save is a single program operation.
+    static const uint32_t slot_size = 256;
+
+    static const uint16_t max_len = slot_size - 16;
+
+    CheckpointStore(FlashDev& dev);
+
+    // Use bytes [base, base + size) of the flash and find the newest valid
+    // checkpoint there. base and size must be multiples of the sector size,
+    // and it must be at least two sectors. Returns false if the region is
+    // no good; loads and saves then fail.
+    bool begin(uint32_t base, uint32_t size);
+
+    // Copy the newest checkpoint to buf (up to max bytes) and return its
+    // length, or 0 if there isn't one.
+    uint16_t load(void *buf, uint16_t max);
+
+    // Write a new checkpoint; false if it couldn't be written and read back.
+    bool save(const void *buf, uint16_t len);
+
+    // sequence number of the newest checkpoint (0 if none)
+    uint32_t seq() const { return _seq; }
+
+    // since begin()
+    uint32_t saves;
+    uint32_t erases;
+    uint32_t failures;
+
+  private:
+
+    FlashDev& _dev;
+    uint32_t _base;
+    uint32_t _size;
+    bool _ok;
+
+    uint32_t _seq;      // newest valid checkpoint
+    uint32_t _slot;     // where it is (if _seq != 0)
+    uint32_t _next;     // slot to try next
+
+    uint32_t slots() const { return _size / slot_size; }
+    uint32_t addr(uint32_t slot) const { return _base + slot * slot_size; }
+
+    // whether slot holds a valid checkpoint; if so, its sequence number
+    bool check(uint32_t slot, uint32_t& seq);
+
+    bool blank(uint32_t slot);
+};
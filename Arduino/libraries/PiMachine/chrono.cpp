@@ -50,6 +50,13 @@ Interval operator-(const Time& t1, const Time& t2)
 }
 
 
+// friend of Time
+bool operator<(const Time& t1, const Time& t2)
+{
+  return t1._ms64 < t2._ms64;
+}
+
+
 // friend of Interval
 bool operator<(const Interval& i1, const Interval& i2)
 {
@@ -57,6 +64,13 @@ bool operator<(const Interval& i1, const Interval& i2)
 }
 
 
+// friend of Interval
+Interval operator+(const Interval& i1, const Interval& i2)
+{
+  return Interval(i1._ms64 + i2._ms64);
+}
+
+
 // friend of both Time and Interval
 Time operator+(const Time& t1, const Interval& i2)
 {
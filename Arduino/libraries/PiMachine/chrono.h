@@ -59,6 +59,7 @@ class Time {
 
     friend Interval operator-(const Time& t1, const Time& t2);
     friend Time operator+(const Time& t1, const Interval& i2);
+    friend bool operator<(const Time& t1, const Time& t2);
 
     friend int64_t get_time_ms64(Time& t); // for debug
 };
@@ -84,4 +85,5 @@ class Interval {
     friend Time;
     friend bool operator<(const Interval& i1, const Interval& i2);
     friend Time operator+(const Time& t1, const Interval& i2);
+    friend Interval operator+(const Interval& i1, const Interval& i2);
 };
@@ -0,0 +1,68 @@
+#include <Arduino.h>
+#include "chrono.h"
+#include "digit_cache.h"
+
+
+DigitCache::DigitCache() :
+  hits(0),
+  misses(0),
+  _highest(-1)
+{
+  clear();
+}
+
+
+void DigitCache::clear()
+{
+  for (int32_t i = 0; i < size; i++) {
+    _entry[i].num = -1;
+    _entry[i].digit = 0;
+    _entry[i].cost_ms = 0;
+  }
+}
+
+
+void DigitCache::put(int32_t num, char digit, const Interval& cost)
+{
+  Entry& e = entry(num);
+  e.num = num;
+  e.digit = digit;
+  e.cost_ms = uint32_t(cost.ms());
+  if (num > _highest)
+    _highest = num;
+}
+
+
+bool DigitCache::get(int32_t num, char& digit)
+{
+  const Entry& e = entry(num);
+  if (e.digit == 0 || e.num != num) {
+    if (num <= _highest)
+      misses++;
+    return false;
+  }
+  hits++;
+  saved = saved + Interval(e.cost_ms);
+  digit = e.digit;
+  return true;
+}
+
+
+void DigitCache::save(int32_t end, char *digits) const
+{
+  for (int32_t i = 0; i < size; i++) {
+    int32_t num = end - size + i;
+    const Entry& e = entry(num);
+    digits[i] = (e.num == num) ? e.digit : 0;
+  }
+}
+
+
+// The computing time of restored digits isn't known (it was spent before
+// the reset), so hits on them don't count toward 'saved'.
+void DigitCache::restore(int32_t end, const char *digits)
+{
+  for (int32_t i = 0; i < size; i++)
+    if (digits[i] != 0)
+      put(end - size + i, digits[i], Interval(0));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "chrono.h"
+
+// The most recently computed digits, by digit number, so that backing up
+// after paper or power out reprints them instead of computing them again.
+//
+// Digit numbers only ever go up by one or back a little, so this is just a
+// ring indexed by digit number: it holds the last 'size' digits computed.
+class DigitCache {
+
+  public:
+
+    // enough to cover backing up after paper out (30), with some to spare
+    static const int32_t size = 64;
+
+    DigitCache();
+
+    // forget everything (not the counters, or the highest digit put)
+    void clear();
+
+    // Remember digit num, and how long it took to compute.
+    void put(int32_t num, char digit, const Interval& cost);
+
+    // Look up digit num; true (and the digit) if it's here. Only digits
+    // up to the highest one put (reprints, after backing up) count as
+    // misses; past that it's just the next digit, not in here yet.
+    bool get(int32_t num, char& digit);
+
+    // Save/restore the digits numbered [end - size, end) for a checkpoint;
+    // unknown ones are 0.
+    void save(int32_t end, char *digits) const;
+    void restore(int32_t end, const char *digits);
+
+    uint32_t hits;
+    uint32_t misses;
+    Interval saved;     // computing time hits have saved
+
+  private:
+
+    struct Entry {
+      int32_t num;
+      char digit;       // 0 if the entry is empty
+      uint32_t cost_ms;
+    };
+
+    Entry _entry[size];
+    int32_t _highest;   // highest digit number put, -1 if none
+
+    Entry& entry(int32_t num) { return _entry[uint32_t(num) % size]; }
+    const Entry& entry(int32_t num) const { return _entry[uint32_t(num) % size]; }
+};
@@ -0,0 +1,323 @@
+#include <Arduino.h>
+#include "chrono.h"
+#include "line_format.h"
+#include "sched.h"
+#include "printer.h"
+#include "print_journal.h"
+#include "digit_sink.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SinkQueue
+
+
+SinkQueue::SinkQueue(DigitSink& sink, Policy policy) :
+  written(0),
+  dropped(0),
+  coalesced(0),
+  blocked(0),
+  high_water(0),
+  _sink(sink),
+  _policy(policy),
+  _pending(false)
+{
+}
+
+
+bool SinkQueue::push(const DigitRecord& r)
+{
+  if (!_ring.push(r))
+    return false;
+  uint32_t n = _ring.size();
+  if (n > high_water)
+    high_water = n;
+  return true;
+}
+
+
+void SinkQueue::flush()
+{
+  if (_pending && push(_pending_rec))
+    _pending = false;
+}
+
+
+bool SinkQueue::offer(const DigitRecord& r)
+{
+  // a coalesced record goes ahead of anything newer
+  flush();
+
+  switch (_policy) {
+
+    case Drop:
+      if (!push(r))
+        dropped++;
+      return true;
+
+    case Block:
+      return push(r);
+
+    case Coalesce:
+      if (_pending || !push(r)) {
+        if (_pending)
+          coalesced++;
+        _pending_rec = r;
+        _pending = true;
+      }
+      return true;
+  }
+
+  return true;
+}
+
+
+void SinkQueue::pump()
+{
+  const DigitRecord *r;
+  while ((r = _ring.front()) != nullptr && _sink.write(*r)) {
+    _ring.pop();
+    written++;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// DigitFanout
+
+
+DigitFanout::DigitFanout() :
+  _num_queues(0)
+{
+}
+
+
+bool DigitFanout::add(SinkQueue& q)
+{
+  if (_num_queues >= max_queues)
+    return false;
+  _queue[_num_queues++] = &q;
+  return true;
+}
+
+
+bool DigitFanout::put(const DigitRecord& r, const Time& until)
+{
+  for (int i = 0; i < _num_queues; i++) {
+    SinkQueue& q = *_queue[i];
+    if (q.offer(r))
+      continue;
+    // Block, and full: let the others move too while waiting
+    q.blocked++;
+    while (true) {
+      pump();
+      if (q.offer(r))
+        break;
+      if (!(Time::now() < until))
+        return false;
+      Time t = next_ready();
+      Sched::sleep_until(until < t ? until : t);
+    }
+  }
+  pump();
+  return true;
+}
+
+
+void DigitFanout::pump()
+{
+  for (int i = 0; i < _num_queues; i++) {
+    _queue[i]->flush();
+    _queue[i]->pump();
+  }
+}
+
+
+bool DigitFanout::drain(const Time& until)
+{
+  while (true) {
+    pump();
+    bool empty = true;
+    for (int i = 0; i < _num_queues; i++)
+      if (_queue[i]->policy() == SinkQueue::Block)
+        empty = empty && _queue[i]->empty();
+    if (empty)
+      return true;
+    if (!(Time::now() < until))
+      return false;
+    Time t = next_ready();
+    Sched::sleep_until(until < t ? until : t);
+  }
+}
+
+
+Time DigitFanout::next_ready()
+{
+  Time t = Time::now() + Interval(1000);
+  for (int i = 0; i < _num_queues; i++) {
+    if (_queue[i]->empty())
+      continue;
+    Time r = _queue[i]->ready_at();
+    if (r < t)
+      t = r;
+  }
+  return t;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SerialTextSink
+
+
+SerialTextSink::SerialTextSink(Print& port, int (*room)()) :
+  _port(port),
+  _room(room)
+{
+}
+
+
+bool SerialTextSink::write(const DigitRecord& r)
+{
+  char buf[line_format::console_len];
+
+  int len = line_format::console_line(buf, r.num, r.digit, r.elapsed_ms,
+                                      r.compute_ms);
+
+  if (_room != nullptr && _room() < len)
+    return false;
+
+  _port.write((const uint8_t *)buf, len);
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SerialBinarySink
+
+
+SerialBinarySink::SerialBinarySink(Print& port, int (*room)()) :
+  _port(port),
+  _room(room)
+{
+}
+
+
+bool SerialBinarySink::write(const DigitRecord& r)
+{
+  if (_room != nullptr && _room() < frame_len)
+    return false;
+
+  uint8_t f[frame_len];
+  uint32_t num = uint32_t(r.num);
+  uint32_t sec = uint32_t(r.elapsed_ms / 1000);
+  f[0] = 0xa5;
+  for (int i = 0; i < 4; i++)
+    f[1 + i] = uint8_t(num >> (8 * i));
+  f[5] = uint8_t(r.digit);
+  for (int i = 0; i < 4; i++)
+    f[6 + i] = uint8_t(sec >> (8 * i));
+  f[10] = 0;
+  for (int i = 0; i < 10; i++)
+    f[10] ^= f[i];
+
+  _port.write(f, frame_len);
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// PrinterSink
+
+
+PrinterSink::PrinterSink(Printer& printer, const Interval& interval,
+                         PrintJournal *journal) :
+  _printer(printer),
+  _interval(interval),
+  _journal(journal)
+{
+}
+
+
+Time PrinterSink::ready_at()
+{
+  Time t = _last + _interval;
+  if (_journal != nullptr) {
+    Time j = _journal->ready_at();
+    if (t < j)
+      t = j;
+  }
+  return t;
+}
+
+
+bool PrinterSink::write(const DigitRecord& r)
+{
+  // Limit print rate so we don't queue up lines in the receive buffer,
+  // which breaks paper-out handling. This is different from worrying
+  // about overrunning the receive buffer; we basically want to know a
+  // digit is on the paper before we try to print another one. (Or, with
+  // the journal, at least which ones might not be.)
+  if (Time::now() < _last + _interval)
+    return false;
+
+  if (_journal != nullptr && _journal->in_flight() >= PrintJournal::depth) {
+    if (!_journal->check())
+      return true; // no paper: this one gets printed again after backing up
+    if (_journal->in_flight() >= PrintJournal::depth)
+      return false;
+  }
+
+  _last = Time::now();
+
+  // large font is 12 pixels wide x 24 pixels high
+
+  // rotated and doubled digit is 48 pixels wide
+  // digit should be centered on 384/2 = 192, so should print at
+  // 192 - (48 / 2) = 168
+
+  // line will be:
+  // digit number: 12 chars @ 12 pixels = 144 pixels
+  // border:        2 chars @ 12 pixels =  24 pixels
+  // digit:         1 char  @ 48 pixels =  48 pixels
+  // border:        2 chars @ 12 pixels =  24 pixels
+  // timestamp:    12 chars @ 12 pixels = 144 pixels
+  // total:                               384 pixels
+
+  char buf[line_format::time_len];
+  static_assert(line_format::time_len >= line_format::num_len, "buf");
+
+  // digit number, 12 chars left-justified (blank if it's not a digit)
+  line_format::number(buf, r.num, r.digit);
+
+  _printer.rotate(false);
+  _printer.mode(Printer::Modes::FontLarge);
+  _printer.print(buf);
+  _printer.print(0xb2); // gray box
+  _printer.print(' ');
+
+  // digit
+  _printer.rotate(true);
+  _printer.mode(Printer::Modes::FontLarge | Printer::Modes::BoldOn |
+                Printer::Modes::Height2x | Printer::Modes::Width2x);
+  _printer.print(r.digit);
+
+  // Timestamp. This will run up against the digit in 11 years, then
+  // do something uglier in 114 years.
+  _printer.rotate(false);
+  _printer.mode(Printer::Modes::FontLarge);
+  _printer.print(' ');
+  _printer.print(0xb2); // gray box
+  if ('0' <= r.digit && r.digit <= '9') {
+    line_format::timestamp(buf, r.elapsed_ms); // 12 chars right-justified
+    _printer.print(buf);
+  }
+
+  _printer.line_space(0);  // lines as close together as possible
+  _printer.flush();        // print buffered data and advance paper
+
+  _printer.mode(); // defaults
+
+  if (_journal != nullptr)
+    _journal->sent(r.pos);
+
+  return true;
+}
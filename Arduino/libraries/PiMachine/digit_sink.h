@@ -0,0 +1,190 @@
+#pragma once
+
+#include <Arduino.h>
+#include "chrono.h"
+#include "spsc_ring.h"
+
+class Printer;
+class PrintJournal;
+
+// One computed (or looked-up) character of pi on its way out, to whatever
+// is listening: console, printer, a file on the host.
+//
+// digit is '0'..'9', or the ' ' and '.' at the start; num and the
+// timestamp only mean something for '0'..'9'.
+struct DigitRecord {
+  int32_t num;          // as printed: the '3' is 0
+  int32_t pos;          // the sketch's own count, to come back to
+  char digit;
+  int64_t elapsed_ms;   // timestamp to print with it
+  int32_t compute_ms;   // how long it took to calculate
+};
+
+
+// Somewhere digits go. write() must not wait: if the sink can't take the
+// record right now (port buffer full, pacing), it returns false and gets
+// the same record again later.
+class DigitSink {
+
+  public:
+
+    virtual bool write(const DigitRecord& r) = 0;
+
+    // when write() might next succeed, if the sink knows (for sleeping)
+    virtual Time ready_at() { return Time::now(); }
+
+};
+
+
+// A sink and the queue in front of it. The producer (DigitFanout::put)
+// offers each record; what happens when the queue is full is the sink's
+// policy:
+//   Drop      lose the new record (a console nobody is reading)
+//   Block     wait for room (the printer: every digit must get there)
+//   Coalesce  keep only the newest waiting record, and send it when there
+//             is room (a display that only shows the latest)
+class SinkQueue {
+
+  public:
+
+    enum Policy { Drop, Block, Coalesce };
+
+    SinkQueue(DigitSink& sink, Policy policy);
+
+    Policy policy() const { return _policy; }
+
+    // Producer side. False only for Block when the queue is full (the
+    // caller waits and offers again).
+    bool offer(const DigitRecord& r);
+
+    // Producer side: move a coalesced record into the queue if there's
+    // room now.
+    void flush();
+
+    // Consumer side: write queued records until the sink says stop.
+    void pump();
+
+    bool empty() const { return _ring.size() == 0 && !_pending; }
+
+    Time ready_at() { return _sink.ready_at(); }
+
+    // statistics
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t coalesced;
+    uint32_t blocked;     // offers that had to wait
+    uint32_t high_water;  // most ever queued
+
+  private:
+
+    DigitSink& _sink;
+    Policy _policy;
+
+    SpscRing<DigitRecord, 16> _ring;
+
+    // Coalesce: newest record that didn't fit (producer side)
+    DigitRecord _pending_rec;
+    bool _pending;
+
+    bool push(const DigitRecord& r);
+};
+
+
+// One stream of digits to several sinks, each with its own queue, so a
+// slow or stuck sink only holds up the others if its policy is Block.
+class DigitFanout {
+
+  public:
+
+    DigitFanout();
+
+    bool add(SinkQueue& q);
+
+    // Give a record to every sink. Returns true once every Block sink has
+    // taken it into its queue, sleeping (and pumping) as needed, or false if
+    // one still hadn't at 'until' (it and the sinks after it don't have it;
+    // the ones before do).
+    bool put(const DigitRecord& r, const Time& until);
+
+    // Move records along to whichever sinks will take them. (This is both
+    // sides of each queue: fine on one thread, which is how the sketches
+    // use it.)
+    void pump();
+
+    // Pump until every Block queue is empty (or give up at 'until'). The
+    // others are best effort and don't hold this up.
+    bool drain(const Time& until);
+
+  private:
+
+    static const int max_queues = 6;
+    SinkQueue *_queue[max_queues];
+    int _num_queues;
+
+    // earliest ready_at() of the queues that have something to send
+    Time next_ready();
+};
+
+
+// Console lines as the sketch has always printed them:
+//   "123         | 5 |     0:01:23     4567"
+class SerialTextSink : public DigitSink {
+
+  public:
+
+    SerialTextSink(Print& port, int (*room)());
+
+    virtual bool write(const DigitRecord& r);
+
+  private:
+
+    Print& _port;
+    int (*_room)();   // bytes that can be written without waiting
+};
+
+
+// Fixed-size frames for a program on the other end of the cable:
+//   0xa5, num (int32 LE), digit, elapsed seconds (uint32 LE), xor of the
+//   previous 10 bytes
+class SerialBinarySink : public DigitSink {
+
+  public:
+
+    static const int frame_len = 11;
+
+    SerialBinarySink(Print& port, int (*room)());
+
+    virtual bool write(const DigitRecord& r);
+
+  private:
+
+    Print& _port;
+    int (*_room)();
+};
+
+
+// The Pi Machine's printed line: number, sideways double-size digit, and
+// timestamp, paced to at most one line per interval (see print_digit).
+//
+// With a journal, each line goes in it, and no more than it has room for
+// are in flight; the interval can then be zero. If the journal is full
+// and the paper has run out, lines are thrown away: going back to the
+// journal's oldest line prints them again anyway.
+class PrinterSink : public DigitSink {
+
+  public:
+
+    PrinterSink(Printer& printer, const Interval& interval,
+                PrintJournal *journal=nullptr);
+
+    virtual bool write(const DigitRecord& r);
+
+    virtual Time ready_at();
+
+  private:
+
+    Printer& _printer;
+    Interval _interval;
+    PrintJournal *_journal;
+    Time _last;
+};
@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include "heat_control.h"
+
+
+HeatControl::HeatControl(const HeatProfile *profiles, int count, int start,
+                         int floor_mv) :
+  rest_mv(0),
+  low_mv(0),
+  lines(0),
+  changes(0),
+  sag_mv(-1),
+  _profiles(profiles),
+  _count(count),
+  _index(start),
+  _floor_mv(floor_mv),
+  _hold(settle_lines),
+  _hi(-1),
+  _lo(-1)
+{
+}
+
+
+void HeatControl::sample(int mv)
+{
+  if (_hi < 0 || mv > _hi)
+    _hi = mv;
+  if (_lo < 0 || mv < _lo)
+    _lo = mv;
+}
+
+
+HeatControl::Change HeatControl::line_done()
+{
+  if (_hi < 0)
+    return Same; // no samples (the first line goes out right away)
+
+  rest_mv = _hi;
+  low_mv = _lo;
+  _hi = _lo = -1;
+  lines++;
+
+  int sag = rest_mv - low_mv;
+  if (sag_mv < 0)
+    sag_mv = sag;
+  else
+    sag_mv += (sag - sag_mv) / 4;
+
+  // Too close: slow down now, or stop if there's nowhere slower to go.
+  if (low_mv < _floor_mv + down_margin_mv) {
+    if (_index + 1 >= _count)
+      return Stop;
+    _index++;
+    changes++;
+    sag_mv = -1; // different profile, different sag
+    _hold = backoff_lines;
+    return Slower;
+  }
+
+  if (_hold > 0) {
+    _hold--;
+    return Same;
+  }
+
+  // Room to spare: would the next faster profile still have some? It heats
+  // up to (dots + 1) times as many dots at once, so assume the sag grows by
+  // that ratio (it's less, if lines don't have that many dots to heat).
+  if (_index > 0) {
+    const HeatProfile& faster = _profiles[_index - 1];
+    int sag_faster = sag_mv * (faster.dots + 1) / (profile().dots + 1);
+    if (rest_mv - sag_faster >= _floor_mv + up_margin_mv) {
+      _index--;
+      changes++;
+      sag_mv = -1;
+      _hold = settle_lines;
+      return Faster;
+    }
+  }
+
+  _hold = settle_lines;
+  return Same;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Printer heat settings and line pace for running from a battery.
+//
+// Printing a line pulls an amp or more, and the battery voltage sags by
+// that times its internal resistance; if the sag reaches the battery's
+// protection cutoff, everything just goes off. Heating fewer dots at a
+// time pulls less current (and takes longer), so there's a ladder of
+// profiles from fast and hungry to slow and gentle. The sketch samples the
+// battery while each line prints and reports it here; HeatControl moves
+// down the ladder as soon as the sag gets close to the floor, and back up
+// when there has been room to spare for a while. When even the gentlest
+// profile sags too far, it's time to stop (gracefully).
+struct HeatProfile {
+  uint8_t dots;       // printer.heat() n1: heat (dots + 1) * 8 dots at a time
+  uint8_t time;       // n2: heating time, 10 usec units
+  uint8_t interval;   // n3: time between heats, 10 usec units
+  uint16_t line_ms;   // time to allow per line
+};
+
+class HeatControl {
+
+  public:
+
+    enum Change { Same, Faster, Slower, Stop };
+
+    // profiles[] fastest first; start is the index to begin with. floor_mv
+    // is the lowest the battery should be seen at while printing.
+    HeatControl(const HeatProfile *profiles, int count, int start,
+                int floor_mv);
+
+    const HeatProfile& profile() const { return _profiles[_index]; }
+    int index() const { return _index; }
+
+    // Battery reading, any time between starting one line and starting
+    // the next.
+    void sample(int mv);
+
+    // Call before starting the next line; says whether to change profile
+    // (profile() is already the new one) or stop.
+    Change line_done();
+
+    // the line just done
+    int rest_mv;        // highest sample (printer idle)
+    int low_mv;         // lowest sample (printer heating)
+
+    // statistics
+    uint32_t lines;
+    uint32_t changes;
+    int sag_mv;         // smoothed rest - low
+
+  private:
+
+    // Go slower if a line dips within this of the floor. Go faster only
+    // if the faster profile's (estimated) dip stays this far above it.
+    static const int down_margin_mv = 50;
+    static const int up_margin_mv = 150;
+
+    // Lines to stay on a profile before trying a faster one, and after
+    // having had to slow down.
+    static const uint32_t settle_lines = 16;
+    static const uint32_t backoff_lines = 256;
+
+    const HeatProfile *_profiles;
+    int _count;
+    int _index;
+    int _floor_mv;
+
+    uint32_t _hold;     // lines left before trying faster
+    int _hi;            // samples so far this line
+    int _lo;
+};
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <string.h>
+#include "line_format.h"
+
+namespace line_format {
+
+const char two_digits[200] = {
+  '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+  '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+  '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+  '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+  '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+  '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+  '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+  '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+  '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+  '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+
+static bool is_digit(char c)
+{
+  return '0' <= c && c <= '9';
+}
+
+
+char *hms_ms(char *p, int64_t ms, int hours_w)
+{
+  const uint64_t u = ms >= 0 ? uint64_t(ms) : 0u - uint64_t(ms);
+
+  // Whole seconds without a 64-bit division: 2^32 msec is 4294967 sec and
+  // 296 msec. (Good for 136 years, which is more than the printer has.)
+  uint32_t hi = uint32_t(u >> 32);
+  uint32_t lo = uint32_t(u);
+  uint32_t s = hi * 4294967u + lo / 1000 + (hi * 296 + lo % 1000) / 1000;
+
+  uint32_t h = s / 3600;
+  uint32_t rest = s - h * 3600;
+  uint32_t m = (rest * 2185) >> 17; // rest / 60, for rest < 3600
+  s = rest - m * 60;
+
+  char tmp[hours_max_width];
+  char *d = digits_before(tmp + hours_max_width, h);
+  if (ms < 0)
+    *--d = '-';
+  int n = int(tmp + hours_max_width - d);
+  p = blanks(p, hours_w - n);
+  memcpy(p, d, n);
+  p += n;
+  *p++ = ':';
+  *p++ = two_digits[2 * m];
+  *p++ = two_digits[2 * m + 1];
+  *p++ = ':';
+  *p++ = two_digits[2 * s];
+  *p++ = two_digits[2 * s + 1];
+  return p;
+}
+
+
+// "<num>| <d> |", or blanks for the number
+static char *head(char *p, int32_t num, char digit)
+{
+  if (is_digit(digit))
+    p = left<num_width>(p, num);
+  else
+    p = blanks(p, num_width);
+  *p++ = '|';
+  *p++ = ' ';
+  *p++ = digit;
+  *p++ = ' ';
+  *p++ = '|';
+  return p;
+}
+
+
+int console_line(char *buf, int32_t num, char digit, int64_t elapsed_ms,
+                 int32_t compute_ms)
+{
+  char *p = head(buf, num, digit);
+  if (is_digit(digit))
+    p = hms<hours_width>(p, elapsed_ms);
+  else
+    p = blanks(p, time_width);
+  p = right<compute_width>(p, compute_ms);
+  *p++ = '\r';
+  *p++ = '\n';
+  *p = '\0';
+  return int(p - buf);
+}
+
+
+int console_head(char *buf, int32_t num, char digit)
+{
+  char *p = head(buf, num, digit);
+  *p = '\0';
+  return int(p - buf);
+}
+
+
+void number(char *buf, int32_t num, char digit)
+{
+  char *p = is_digit(digit) ? left<num_width>(buf, num) : blanks(buf, num_width);
+  *p = '\0';
+}
+
+
+void timestamp(char *buf, int64_t elapsed_ms)
+{
+  char *p = hms<hours_width>(buf, elapsed_ms);
+  *p = '\0';
+}
+
+} // namespace line_format
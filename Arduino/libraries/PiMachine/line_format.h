@@ -0,0 +1,159 @@
+#pragma once
+
+// Digit lines without printf. Each line is a fixed layout: the widths of
+// its fields are constants here (so buffers are sized at compile time) and
+// template arguments to the routines that write them, which put the
+// characters straight into the buffer. What comes out is the same as the
+// snprintf formats these replace, shown with each.
+//
+// That keeps newlib's printf (several K of flash) out of sketches that
+// only format digit lines, and it's quicker: the timestamp takes one
+// 32-bit division instead of the 64-bit ones in Interval::hmsm(), which are
+// library calls on these CPUs.
+//
+// The writers return where they stopped; nothing is terminated unless the
+// line function says so.
+
+#include <Arduino.h>
+#include <string.h>
+
+namespace line_format {
+
+// digit number, left-justified ("%-12ld")
+constexpr int num_width = 12;
+
+// timestamp: hours right-justified, then minutes and seconds ("%6lu:%02lu:%02lu")
+constexpr int hours_width = 6;
+constexpr int time_width = hours_width + 6;
+
+// msec to compute the digit, right-justified ("%9ld")
+constexpr int compute_width = 9;
+
+// widest fields can get when the value doesn't fit ("-2147483648", and
+// the hours in 2^32 sec, 136 years, with a '-')
+constexpr int int32_max_width = 11;
+constexpr int hours_max_width = 11;
+
+constexpr int wider(int a, int b) { return a > b ? a : b; }
+
+constexpr int num_max = wider(num_width, int32_max_width);
+constexpr int time_max = wider(hours_width, hours_max_width) + 6;
+constexpr int compute_max = wider(compute_width, int32_max_width);
+
+// "<num>| <d> |<time><compute>\r\n", with a terminator
+constexpr int console_len = num_max + 5 + time_max + compute_max + 2 + 1;
+
+// "<num>| <d> |" (the Tiny's console), with a terminator
+constexpr int console_head_len = num_max + 5 + 1;
+
+// the printer's number and timestamp fields, each with a terminator
+constexpr int num_len = num_max + 1;
+constexpr int time_len = time_max + 1;
+
+// "00" .. "99"
+extern const char two_digits[200];
+
+// v in decimal, ending just before end; returns where it starts
+inline char *digits_before(char *end, uint32_t v)
+{
+  while (v >= 100) {
+    uint32_t q = v / 100;
+    const char *d = two_digits + 2 * (v - q * 100);
+    *--end = d[1];
+    *--end = d[0];
+    v = q;
+  }
+  if (v >= 10) {
+    const char *d = two_digits + 2 * v;
+    *--end = d[1];
+    *--end = d[0];
+  } else {
+    *--end = char('0' + v);
+  }
+  return end;
+}
+
+// v in decimal into tmp (at least 11 chars), with a '-' if it's negative;
+// returns the length and sets *start
+inline int to_decimal(char *tmp, int32_t v, char **start)
+{
+  char *end = tmp + int32_max_width;
+  uint32_t u = v < 0 ? 0u - uint32_t(v) : uint32_t(v);
+  char *p = digits_before(end, u);
+  if (v < 0)
+    *--p = '-';
+  *start = p;
+  return int(end - p);
+}
+
+inline char *blanks(char *p, int n)
+{
+  while (n-- > 0)
+    *p++ = ' ';
+  return p;
+}
+
+// "%-<W>ld"
+template <int W>
+inline char *left(char *p, int32_t v)
+{
+  char tmp[int32_max_width];
+  char *d;
+  int n = to_decimal(tmp, v, &d);
+  memcpy(p, d, n);
+  return blanks(p + n, W - n);
+}
+
+// "%<W>ld"
+template <int W>
+inline char *right(char *p, int32_t v)
+{
+  char tmp[int32_max_width];
+  char *d;
+  int n = to_decimal(tmp, v, &d);
+  p = blanks(p, W - n);
+  memcpy(p, d, n);
+  return p + n;
+}
+
+// plain text, and "%ld", for the odd message
+inline char *text(char *p, const char *s)
+{
+  while (*s != '\0')
+    *p++ = *s++;
+  return p;
+}
+
+inline char *decimal(char *p, int32_t v)
+{
+  return left<0>(p, v);
+}
+
+// ms (under 2^32 sec either way) as "%<W>lu:%02lu:%02lu" hours, minutes,
+// seconds. If it's negative, a '-' goes just before the hours, in their
+// width. (Interval::hmsm() and so the old formats left it off.)
+char *hms_ms(char *p, int64_t ms, int hours_w);
+
+template <int W>
+inline char *hms(char *p, int64_t ms)
+{
+  return hms_ms(p, ms, W);
+}
+
+// A whole console line for a digit (or the '.', which gets no number or
+// timestamp); returns the length.
+//   "%-12ld| %c |%6lu:%02lu:%02lu%9ld\r\n"
+//   "            | %c |            %9ld\r\n"
+int console_line(char *buf, int32_t num, char digit, int64_t elapsed_ms,
+                 int32_t compute_ms);
+
+// The start of one, as the Tiny prints it:
+//   "%-12ld| %c |" or "            | %c |"
+int console_head(char *buf, int32_t num, char digit);
+
+// The printer's fields, terminated:
+//   "%-12ld" or 12 spaces, and "%6lu:%02lu:%02lu"
+void number(char *buf, int32_t num, char digit);
+void timestamp(char *buf, int64_t elapsed_ms);
+
+} // namespace line_format
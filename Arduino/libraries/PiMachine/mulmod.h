@@ -0,0 +1,226 @@
+#pragma once
+
+// Arithmetic modulo m for DigitsOfPi, specialized by how wide m is. The
+// engine (pidec.cpp) is a template over these; it splits its moduli into
+// ranges by width and runs each range with the narrowest that fits.
+//
+//   Modulus<31>  m < 2^31. a*b is one 32x32->64 multiply (UMULL), and the
+//                remainder comes from a precomputed reciprocal of m with
+//                32-bit multiplies (Moller and Granlund, "Improved division
+//                by invariant integers", 2011): no division, no doubles.
+//                (On a 64-bit host, one 64x64 high multiply does instead.)
+//                Every modulus in DigitsOfPi is this narrow until n is well
+//                over a million.
+//   Modulus<48>  m < 2^48. The quotient comes from a double; not fully
+//                reduced, and fast where there's a double FPU (the host),
+//                but software floating point on a Cortex-M4.
+//   Modulus<63>  m < 2^62. Exact, with 128-bit products where the compiler
+//                has them and shift-and-add where it doesn't. Slow, but
+//                right.
+//
+// The engine keeps to what all three allow: Mul(a, b) and SumMul(a, b, c,
+// d) take a and c reduced (0 <= a < m, or what one of these returned) and
+// b and d in [0, max_mul); sums of results go through Add(). word is wide
+// enough for m, for the rest of the engine's arithmetic (gcd, factoring)
+// on the same modulus.
+
+#include <Arduino.h>
+
+template <int Bits> class Modulus;
+
+
+template <>
+class Modulus<31> {
+
+  public:
+
+    static const int bits = 31;
+    static const int64_t max_mul = int64_t(1) << 31;
+    typedef int32_t word;
+
+#if defined(__SIZEOF_INT128__)
+    explicit Modulus(int64_t m) :
+      _m(uint32_t(m)),
+      _r(~uint64_t(0) / uint32_t(m))
+    {
+    }
+#else
+    explicit Modulus(int64_t m) :
+      _m(uint32_t(m)),
+      _shift(__builtin_clz(uint32_t(m))),
+      _d(uint32_t(m) << _shift),
+      _v(uint32_t(~uint64_t(0) / _d))
+    {
+    }
+#endif
+
+    int64_t m() const { return _m; }
+
+    int64_t Mul(int64_t a, int64_t b) const
+    {
+      return Rem(uint64_t(a) * uint64_t(b));
+    }
+
+    int64_t SumMul(int64_t a, int64_t b, int64_t c, int64_t d) const
+    {
+      // each product is below m * 2^31, so the sum is below m * 2^32
+      return Rem(uint64_t(a) * uint64_t(b) + uint64_t(c) * uint64_t(d));
+    }
+
+    int64_t Add(int64_t a, int64_t b) const
+    {
+      uint32_t s = uint32_t(a) + uint32_t(b);
+      return s >= _m ? s - _m : s;
+    }
+
+    // 0 <= x < 2^63
+    int64_t Reduce(int64_t x) const
+    {
+      uint32_t hi = uint32_t(uint64_t(x) >> 32) % _m;
+      return Rem((uint64_t(hi) << 32) | uint32_t(x));
+    }
+
+  private:
+
+    uint32_t _m;
+
+#if defined(__SIZEOF_INT128__)
+    // A 64-bit host: one high multiply by floor((2^64 - 1) / _m) gets the
+    // quotient, or one less.
+    uint64_t _r;
+
+    uint32_t Rem(uint64_t t) const
+    {
+      uint64_t q = uint64_t(((unsigned __int128)t * _r) >> 64);
+      uint64_t r = t - q * _m;
+      return uint32_t(r >= _m ? r - _m : r);
+    }
+#else
+    int _shift;     // _m << _shift has its top bit set
+    uint32_t _d;    // that
+    uint32_t _v;    // floor((2^64 - 1) / _d) - 2^32
+
+    // t mod _m, for t < _m * 2^32 (so t << _shift still fits, and its top
+    // half is less than _d)
+    uint32_t Rem(uint64_t t) const
+    {
+      t <<= _shift;
+      uint32_t u1 = uint32_t(t >> 32);
+      uint32_t u0 = uint32_t(t);
+      uint64_t q = uint64_t(_v) * u1 + t;
+      uint32_t q1 = uint32_t(q >> 32) + 1;
+      uint32_t r = u0 - q1 * _d;
+      if (r > uint32_t(q))
+        r += _d;
+      if (r >= _d)
+        r -= _d;
+      return r >> _shift;
+    }
+#endif
+
+};
+
+
+template <>
+class Modulus<48> {
+
+  public:
+
+    static const int bits = 48;
+    static const int64_t max_mul = int64_t(1) << 50;
+    typedef int64_t word;
+
+    explicit Modulus(int64_t m) :
+      _m(m),
+      _invm(1. / double(m))
+    {
+    }
+
+    int64_t m() const { return _m; }
+
+    // Not fully reduced: a*b - q*_m where q is a*b/_m as a double. Works
+    // whenever a*b/_m is less than 2^52 (double precision), and the int64_t
+    // products wrapping doesn't matter since the answer is small.
+    int64_t Mul(int64_t a, int64_t b) const
+    {
+      int64_t q = (int64_t)(_invm * (double)a * (double)b);
+      return a * b - q * _m;
+    }
+
+    int64_t SumMul(int64_t a, int64_t b, int64_t c, int64_t d) const
+    {
+      int64_t q = (int64_t)(_invm * ((double)a * (double)b + (double)c * (double)d));
+      return a * b + c * d - q * _m;
+    }
+
+    // (Mul's slack covers a sum or two.)
+    int64_t Add(int64_t a, int64_t b) const { return a + b; }
+
+    int64_t Reduce(int64_t x) const { return x % _m; }
+
+  private:
+
+    int64_t _m;
+    double _invm;
+
+};
+
+
+template <>
+class Modulus<63> {
+
+  public:
+
+    static const int bits = 63;
+    static const int64_t max_mul = int64_t(1) << 62;
+    typedef int64_t word;
+
+    explicit Modulus(int64_t m) :
+      _m(uint64_t(m))
+    {
+    }
+
+    int64_t m() const { return int64_t(_m); }
+
+    int64_t Mul(int64_t a, int64_t b) const
+    {
+#if defined(__SIZEOF_INT128__)
+      return int64_t((unsigned __int128)uint64_t(a) * uint64_t(b) % _m);
+#else
+      // a + a can't overflow with _m < 2^63
+      uint64_t x = uint64_t(a) % _m;
+      uint64_t y = uint64_t(b);
+      uint64_t r = 0;
+      while (y != 0) {
+        if (y & 1) {
+          r += x;
+          if (r >= _m)
+            r -= _m;
+        }
+        x += x;
+        if (x >= _m)
+          x -= _m;
+        y >>= 1;
+      }
+      return int64_t(r);
+#endif
+    }
+
+    int64_t SumMul(int64_t a, int64_t b, int64_t c, int64_t d) const
+    {
+      return Add(Mul(a, b), Mul(c, d));
+    }
+
+    int64_t Add(int64_t a, int64_t b) const
+    {
+      uint64_t s = uint64_t(a) + uint64_t(b);
+      return int64_t(s >= _m ? s - _m : s);
+    }
+
+    int64_t Reduce(int64_t x) const { return int64_t(uint64_t(x) % _m); }
+
+  private:
+
+    uint64_t _m;
+
+};
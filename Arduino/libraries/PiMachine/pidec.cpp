@@ -1,35 +1,12 @@
 #include <Arduino.h>
+#include <limits.h>
 #include <math.h>
 #include <pidec.h>
+#include "mulmod.h"
 
-static int64_t _m;
-static double _invm;
-
-
-static void InitializeModulo(int64_t m)
-{
-  _m = m;
-  _invm = 1. / (double)m;
-}
-
-
-// Compute a*b modulo _m
-inline int64_t MulMod(int64_t a, int64_t b)
-{
-  // classical trick to bypass the 64-bit limitation, when a*b does not fit into
-  // the int64_t type. Works whenever a*b/_m is less than 2^52 (double type
-  // maximal precision)
-  int64_t q = (int64_t)(_invm * (double)a * (double)b);
-  return a * b - q * _m;
-}
-
-
-// Compute a*b+c*d modulo _m
-inline int64_t SumMulMod(int64_t a, int64_t b, int64_t c, int64_t d)
-{
-  int64_t q = (int64_t)(_invm * ((double)a * (double)b + (double)c * (double)d));
-  return a * b + c * d - q * _m;
-}
+// Moduli at least this wide go to the next wider Modulus, whether or not
+// they'd fit (see DigitsOfPiWidth).
+static int _min_bits = 0;
 
 
 inline double easyround(double x)
@@ -41,16 +18,17 @@ inline double easyround(double x)
 }
 
 
-/* return g, A such that g=gcd(a,_m) and a*A=g mod _m  */
-static int64_t ExtendedGcd(int64_t a, int64_t& A)
+/* return g, A such that g=gcd(a,m) and a*A=g mod m  */
+template <typename W>
+static W ExtendedGcd(W a, W m, W& A)
 {
-  int64_t A0 = 1, A1 = 0;
-  int64_t r0 = a, r1 = _m;
+  W A0 = 1, A1 = 0;
+  W r0 = a, r1 = m;
 
-  while (r1 > 0.) {
-    int64_t q = r0 / r1;
+  while (r1 > 0) {
+    W q = r0 / r1;
 
-    int64_t tmp = A0 - q * A1;
+    W tmp = A0 - q * A1;
     A0 = A1;
     A1 = tmp;
 
@@ -63,98 +41,231 @@ static int64_t ExtendedGcd(int64_t a, int64_t& A)
 }
 
 
-static int64_t InvMod(int64_t a)
+// 1/a mod m, 0 <= result < m
+template <class K>
+static int64_t InvMod(const K& md, int64_t a)
 {
-  int64_t A;
-  a = a % _m;
+  typedef typename K::word W;
+  W m = W(md.m());
+  W A;
+  a = a % md.m();
   if (a < 0)
-    a += _m;
-  (void)ExtendedGcd(a, A);
-  return A;
+    a += md.m();
+  (void)ExtendedGcd<W>(W(a), m, A);
+  return A < 0 ? A + m : A;
 }
 
 
-static int64_t PowMod(int64_t a, long b)
+// Precomputed exponentiation c * a^e * b^f mod m, for exponents that stay
+// the same while the modulus changes (every modulus in DigitsOfPi uses the
+// same few exponents).
+//
+// The schedule is left-to-right with sliding windows over the bits of e and
+// f together, so a^e*b^f costs one squaring per bit of the longer exponent
+// instead of one per bit of each. Because a and b are small, the multiplier
+// for a window (a^da * b^db) is used as a plain number: no per-modulus table
+// of powers, it just has to be small enough for every Modulus (max_mul). The
+// top bits are done exactly at construction time, which skips the first
+// several squarings, and c is folded into the last multiplier when it fits.
+class PowChain
 {
-  int64_t r, aa;
+  public:
 
-  r = 1;
-  aa = a;
-  while (1) {
-    if (b & 1)
-      r = MulMod(r, aa);
-    b >>= 1;
-    if (b == 0)
-      break;
-    aa = MulMod(aa, aa);
+    PowChain(int64_t a, long e, int64_t b = 1, long f = 0, int64_t c = 1);
+
+    // c * a^e * b^f mod md.m(), reduced as much as md reduces
+    template <class K>
+    int64_t Eval(const K& md) const;
+
+  private:
+
+    // window multipliers must stay below this (the narrowest Modulus's
+    // max_mul, so one schedule does for all)
+    static const int64_t MaxMul = int64_t(1) << 31;
+
+    // the exact head must fit in int64_t
+    static const int64_t MaxHead = int64_t(1) << 62;
+
+    // enough for exponents < 2^32 (each step is at least one bit)
+    static const int MaxSteps = 32;
+
+    int64_t _head;
+
+    struct Step {
+      int squarings;
+      int64_t mul;
+    };
+    Step _step[MaxSteps];
+    int _num_steps;
+    int _tail_squarings;
+
+    // c, if it couldn't be folded into the last step
+    int64_t _tail_mul;
+};
+
+
+// x^k, or 0 if it would be limit or more
+static int64_t PowLimit(int64_t x, long k, int64_t limit)
+{
+  int64_t r = 1;
+  while (k-- > 0) {
+    if (r >= limit / x)
+      return 0;
+    r *= x;
   }
   return r;
 }
 
 
-/* Compute sum_{j=0}^k binomial(n,j) mod m */
-static int64_t SumBinomialMod(long n, long k)
+PowChain::PowChain(int64_t a, long e, int64_t b, long f, int64_t c)
 {
-  // Optimisation : when k>n/2 we use the relation
-  // sum_{j=0}^k binomial(n,j) =  2^n - sum_{j=0}^{n-k-1} binomial(n,j)
-  //
-  // Note : additionnal optimization, not afforded here, could be done when k is
-  // near n/2 using the identity sum_{j=0}^{n/2} = 2^(n-1) + 1/2
-  // binomial(n,n/2). A global saving of 20% or 25% could be obtained.
-  if (k > n / 2) {
-    int64_t s = PowMod(2, n) - SumBinomialMod(n, n - k - 1);
-    if (s < 0)
-      s += _m;
-    return s;
+  int bits = 0;
+  while (bits < 63 && ((e >> bits) != 0 || (f >> bits) != 0))
+    bits++;
+
+  // exponent bits [bit, bits) of e and f
+  auto top_e = [&](int bit) { return e >> bit; };
+  auto top_f = [&](int bit) { return f >> bit; };
+  auto window_e = [&](int hi, int lo) { return (e >> lo) & ((1L << (hi - lo)) - 1); };
+  auto window_f = [&](int hi, int lo) { return (f >> lo) & ((1L << (hi - lo)) - 1); };
+
+  // head: as many top bits as can be done exactly
+  int pos = bits;
+  _head = 1;
+  while (pos > 0) {
+    int64_t pa = PowLimit(a, top_e(pos - 1), MaxHead);
+    int64_t pb = PowLimit(b, top_f(pos - 1), MaxHead);
+    if (pa == 0 || pb == 0 || pa >= MaxHead / pb)
+      break;
+    _head = pa * pb;
+    pos--;
   }
-  //
-  // Compute prime factors of _m which are smaller than k
-  //
-  const long NbMaxFactors = 20; // no more than 20 different prime factors for numbers <2^64
-  long PrimeFactor[NbMaxFactors];
-  long NbPrimeFactors = 0;
-  int64_t mm = _m;
-  // _m is odd, thus has only odd prime factors
-  for (int64_t p = 3; p * p <= mm; p += 2) {
-    if (mm % p == 0) {
-      mm = mm / p;
-      if (p <= k) // only prime factors <=k are needed
-        PrimeFactor[NbPrimeFactors++] = p;
-      while (mm % p == 0)
-        mm = mm / p; // remove all powers of p in mm
+
+  // windows: start at a one bit, take as many bits as the multiplier
+  // allows, then give back trailing zeros (they're just squarings)
+  _num_steps = 0;
+  int squarings = 0;
+  while (pos > 0) {
+    if (((e >> (pos - 1)) & 1) == 0 && ((f >> (pos - 1)) & 1) == 0) {
+      squarings++;
+      pos--;
+      continue;
+    }
+    int lo = pos - 1;
+    while (lo > 0) {
+      int64_t pa = PowLimit(a, window_e(pos, lo - 1), MaxMul);
+      int64_t pb = PowLimit(b, window_f(pos, lo - 1), MaxMul);
+      if (pa == 0 || pb == 0 || pa >= MaxMul / pb)
+        break;
+      lo--;
     }
+    while (((e >> lo) & 1) == 0 && ((f >> lo) & 1) == 0)
+      lo++;
+    _step[_num_steps].squarings = squarings + (pos - lo);
+    _step[_num_steps].mul = PowLimit(a, window_e(pos, lo), MaxMul) * PowLimit(b, window_f(pos, lo), MaxMul);
+    _num_steps++;
+    squarings = 0;
+    pos = lo;
   }
-  // last factor : if mm is not 1, mm is necessarily prime
-  if (mm > 1 && mm <= k) {
-    PrimeFactor[NbPrimeFactors++] = mm;
+  _tail_squarings = squarings;
+
+  _tail_mul = c;
+  if (_tail_squarings == 0 && _num_steps > 0 && _step[_num_steps - 1].mul < MaxMul / c) {
+    _step[_num_steps - 1].mul *= c;
+    _tail_mul = 1;
+  } else if (_num_steps == 0 && _tail_squarings == 0 && _head < MaxHead / c) {
+    _head *= c;
+    _tail_mul = 1;
+  }
+}
+
+
+template <class K>
+int64_t PowChain::Eval(const K& md) const
+{
+  int64_t r = md.Reduce(_head);
+  for (int i = 0; i < _num_steps; i++) {
+    for (int j = _step[i].squarings; j > 0; j--)
+      r = md.Mul(r, r);
+    r = md.Mul(r, _step[i].mul);
   }
+  for (int j = _tail_squarings; j > 0; j--)
+    r = md.Mul(r, r);
+  if (_tail_mul != 1)
+    r = md.Mul(r, _tail_mul);
+  return r;
+}
+
+
+static const long NbMaxFactors = 20; // no more than 20 different prime factors for numbers <2^64
 
-  // BinomialExponent[i] will contain the power of PrimeFactor[i] in binomial
+
+/* The j loop of SumBinomialMod. PrimeFactor[] are the NbPrimeFactors prime
+ * factors of m that are <= k; NbFactors is the same number when it is known
+ * at compile time, or -1 if not.
+ *
+ * A factor p only matters at the j where p divides n-j+1 or j, so rather than
+ * testing every factor at every j, the loop runs plain steps up to the next
+ * such j (the nearest event over all factors), then handles that one j. In
+ * between, num and denom need nothing removed and BinomialSecondary does not
+ * change. With few factors (the usual case) the event search unrolls. */
+template <class K, int NbFactors>
+static int64_t SumBinomialLoop(const K& md, long n, long k, const long *PrimeFactor,
+                               long NbPrimeFactors)
+{
+  const long nf = NbFactors >= 0 ? NbFactors : NbPrimeFactors;
+
+  // BinomialPower[i] will contain the power of PrimeFactor[i] in binomial
   long BinomialPower[NbMaxFactors];
-  // NextDenom[i] and NextNum[i] will contain next multiples of PrimeFactor[i]
+  // NextDenom[i] and NextNum[i] will contain the next j where PrimeFactor[i]
+  // divides j and n-j+1
   long NextDenom[NbMaxFactors], NextNum[NbMaxFactors];
-  for (long i = 0; i < NbPrimeFactors; i++) {
+  for (long i = 0; i < nf; i++) {
     BinomialPower[i] = 1;
     NextDenom[i] = PrimeFactor[i];
-    NextNum[i] = PrimeFactor[i] * (n / PrimeFactor[i]);
+    NextNum[i] = n + 1 - PrimeFactor[i] * (n / PrimeFactor[i]);
   }
 
   int64_t BinomialNum0 = 1, BinomialDenom = 1;
   int64_t SumNum = 1;
   int64_t BinomialSecondary = 1;
 
-  for (long j = 1; j <= k; j++) {
+  long j = 1;
+  while (j <= k) {
+    long event = k + 1;
+    for (long i = 0; i < nf; i++) {
+      if (NextNum[i] < event)
+        event = NextNum[i];
+      if (NextDenom[i] < event)
+        event = NextDenom[i];
+    }
+
     // new binomial : b(n,j) = b(n,j-1) * (n-j+1) / j
+    if (BinomialSecondary != 1) {
+      for (; j < event; j++) {
+        BinomialNum0 = md.Mul(BinomialNum0, n - j + 1);
+        BinomialDenom = md.Mul(BinomialDenom, j);
+        SumNum = md.SumMul(SumNum, j, BinomialNum0, BinomialSecondary);
+      }
+    } else {
+      for (; j < event; j++) {
+        BinomialNum0 = md.Mul(BinomialNum0, n - j + 1);
+        BinomialDenom = md.Mul(BinomialDenom, j);
+        SumNum = md.Add(md.Mul(SumNum, j), BinomialNum0);
+      }
+    }
+    if (j > k)
+      break;
+
+    // j is an event: take the factors out of num and denom
     int64_t num = n - j + 1;
     int64_t denom = j;
-    int BinomialSecondaryUpdate = 0;
 
-    for (long i = 0; i < NbPrimeFactors; i++) {
+    for (long i = 0; i < nf; i++) {
       long p = PrimeFactor[i];
       // Test if p is a prime factor of num0
-      if (NextNum[i] == n - j + 1) {
-        BinomialSecondaryUpdate = 1;
-        NextNum[i] -= p;
+      if (NextNum[i] == j) {
+        NextNum[i] += p;
         BinomialPower[i] *= p;
         num /= p;
         while (num % p == 0) {
@@ -164,7 +275,6 @@ static int64_t SumBinomialMod(long n, long k)
       }
       // Test if p is a prime factor of denom0
       if (NextDenom[i] == j) {
-        BinomialSecondaryUpdate = 1;
         NextDenom[i] += p;
         BinomialPower[i] /= p;
         denom /= p;
@@ -175,66 +285,254 @@ static int64_t SumBinomialMod(long n, long k)
       }
     }
 
-    if (BinomialSecondaryUpdate) {
-      BinomialSecondary = BinomialPower[0];
-      for (long i = 1; i < NbPrimeFactors; i++)
-        BinomialSecondary = MulMod(BinomialSecondary, BinomialPower[i]);
-    }
+    BinomialSecondary = nf > 0 ? BinomialPower[0] : 1;
+    for (long i = 1; i < nf; i++)
+      BinomialSecondary = md.Mul(BinomialSecondary, BinomialPower[i]);
 
-    BinomialNum0 = MulMod(BinomialNum0, num);
-    BinomialDenom = MulMod(BinomialDenom, denom);
+    BinomialNum0 = md.Mul(BinomialNum0, num);
+    BinomialDenom = md.Mul(BinomialDenom, denom);
 
     if (BinomialSecondary != 1) {
-      SumNum = SumMulMod(SumNum, denom, BinomialNum0, BinomialSecondary);
+      SumNum = md.SumMul(SumNum, denom, BinomialNum0, BinomialSecondary);
     } else {
-      SumNum = MulMod(SumNum, denom) + BinomialNum0;
+      SumNum = md.Add(md.Mul(SumNum, denom), BinomialNum0);
     }
+    j++;
   }
-  SumNum = MulMod(SumNum, InvMod(BinomialDenom));
+  SumNum = md.Mul(SumNum, InvMod(md, BinomialDenom));
   return SumNum;
 }
 
 
-/* return fractionnal part of 10^n*(a/b) */
-static double DigitsOfFraction(long n, int64_t a, int64_t b)
+/* Compute sum_{j=0}^k binomial(n,j) mod m. pow2n is 2^n. */
+template <class K>
+static int64_t SumBinomialMod(const K& md, long n, long k, const PowChain& pow2n)
+{
+  // Optimisation : when k>n/2 we use the relation
+  // sum_{j=0}^k binomial(n,j) =  2^n - sum_{j=0}^{n-k-1} binomial(n,j)
+  //
+  // Note : the original suggests an additional optimization when k is near
+  // n/2, using the identity sum_{j=0}^{n/2} = 2^(n-1) + 1/2 binomial(n,n/2),
+  // for a saving of 20% or 25%. It doesn't pay here: m is different for
+  // every k, so binomial(n,n/2) mod m has to be built up from j=1 each time,
+  // which is n/2 steps, more than the k (or n-k) steps it would replace.
+  if (k > n / 2) {
+    int64_t s = pow2n.Eval(md) - SumBinomialMod(md, n, n - k - 1, pow2n);
+    if (s < 0)
+      s += md.m();
+    return s;
+  }
+  //
+  // Compute prime factors of m which are smaller than k
+  //
+  typedef typename K::word W;
+  long PrimeFactor[NbMaxFactors];
+  long NbPrimeFactors = 0;
+  W mm = W(md.m());
+  // m is odd, thus has only odd prime factors
+  for (W p = 3; p <= mm / p; p += 2) {
+    if (mm % p == 0) {
+      mm = mm / p;
+      if (p <= k) // only prime factors <=k are needed
+        PrimeFactor[NbPrimeFactors++] = p;
+      while (mm % p == 0)
+        mm = mm / p; // remove all powers of p in mm
+    }
+  }
+  // last factor : if mm is not 1, mm is necessarily prime
+  if (mm > 1 && mm <= k) {
+    PrimeFactor[NbPrimeFactors++] = mm;
+  }
+
+  switch (NbPrimeFactors) {
+    case 0: return SumBinomialLoop<K, 0>(md, n, k, PrimeFactor, NbPrimeFactors);
+    case 1: return SumBinomialLoop<K, 1>(md, n, k, PrimeFactor, NbPrimeFactors);
+    case 2: return SumBinomialLoop<K, 2>(md, n, k, PrimeFactor, NbPrimeFactors);
+    case 3: return SumBinomialLoop<K, 3>(md, n, k, PrimeFactor, NbPrimeFactors);
+    default: return SumBinomialLoop<K, -1>(md, n, k, PrimeFactor, NbPrimeFactors);
+  }
+}
+
+
+/* return fractionnal part of 10^n*(a/b), where pow is a*10^n */
+template <class K>
+static double DigitsOfFraction(const PowChain& pow, int64_t b)
 {
-  InitializeModulo(b);
-  int64_t pow = PowMod(10, n);
-  int64_t c = MulMod(pow, a);
+  const K md(b);
+  int64_t c = pow.Eval(md);
   return (double)c / (double)b;
 }
 
 
+/* The terms of the series for k in [k0, k1) (k0 even). */
+template <class K>
+static double SeriesRange(const PowChain& pow, int64_t k0, int64_t k1)
+{
+  double x = 0.;
+  for (int64_t k = k0; k < k1; k += 2) {
+    x += DigitsOfFraction<K>(pow, 2 * k + 1) - DigitsOfFraction<K>(pow, 2 * k + 3);
+    x = x - easyround(x);
+  }
+  return x;
+}
+
+
+// First even k whose moduli 2k+1 and 2k+3 don't fit Modulus<bits>, or 0 if
+// that width isn't to be used.
+static int64_t SeriesLimit(int bits)
+{
+  if (bits < _min_bits)
+    return 0;
+  int64_t k = ((int64_t(1) << bits) - 3) / 2 + 1;
+  return k + k % 2;
+}
+
+
 /* return fractionnal part of 10^n*S, where S=4*sum_{k=0}^{m-1} (-1)^k/(2*k+1).
- * m is even */
+ * m is even. The moduli grow with k, so each run of them goes to the
+ * narrowest Modulus that fits. */
 static double DigitsOfSeries(long n, int64_t m)
 {
+  const PowChain pow(10, n, 1, 0, 4); // 4*10^n
   double x = 0.;
-  for (int64_t k = 0; k < m; k += 2) {
-    x += DigitsOfFraction(n, 4, 2 * k + 1) - DigitsOfFraction(n, 4, 2 * k + 3);
-    x = x - easyround(x);
+  int64_t k = 0;
+  int64_t e = SeriesLimit(31) < m ? SeriesLimit(31) : m;
+  if (k < e) {
+    x += SeriesRange<Modulus<31>>(pow, k, e);
+    k = e;
+  }
+  e = SeriesLimit(48) < m ? SeriesLimit(48) : m;
+  if (k < e) {
+    x += SeriesRange<Modulus<48>>(pow, k, e);
+    k = e;
+  }
+  if (k < m)
+    x += SeriesRange<Modulus<63>>(pow, k, m);
+  return x - easyround(x);
+}
+
+
+/* The binomial terms for k in [k0, k1), modulus base+2k. */
+template <class K>
+static double BinomialRange(long N, int64_t base, long k0, long k1,
+                            const PowChain& scale, const PowChain& pow2N)
+{
+  double x = 0.;
+  for (long k = k0; k < k1; k++) {
+    const K md(base + 2 * k);
+    int64_t s = SumBinomialMod(md, N, k, pow2N);
+    s = md.Mul(s, scale.Eval(md));
+    x += (2 * (k % 2) - 1) * (double)s / (double)md.m(); // 2*(k%2)-1 = (-1)^(k-1)
+    x = x - floor(x);
   }
   return x;
 }
 
 
-double DigitsOfPi(long n)
+// First k whose modulus base+2k doesn't fit Modulus<bits>, or 0 if that
+// width isn't to be used.
+static long BinomialLimit(int bits, int64_t base)
+{
+  int64_t top = int64_t(1) << bits;
+  if (bits < _min_bits || base >= top)
+    return 0;
+  int64_t k = (top - base + 1) / 2;
+  return k < LONG_MAX ? long(k) : LONG_MAX;
+}
+
+
+void DigitsOfPiWidth(int min_bits)
+{
+  _min_bits = min_bits;
+}
+
+
+static const PiTune *_tune = pi_tune;
+
+
+void DigitsOfPiTune(const PiTune *table)
+{
+  _tune = table;
+}
+
+
+// M for n from the tune table; M is even
+static long SeriesLength(long n)
 {
   double logn = log((double)n);
-  long M = 2 * (long)(3. * n / logn / logn / logn); // M is even
+  double m = 3. * n / logn / logn / logn;
+  for (const PiTune *t = _tune; t->n_max != 0; t++) {
+    if (n <= t->n_max) {
+      m *= t->m_scale;
+      break;
+    }
+  }
+  long M = 2 * (long)m;
+  return M < 2 ? 2 : M;
+}
+
+
+// N for n and M; N is even
+static long BinomialTerms(long n, long M)
+{
   long N = 1 + (long)((n + 15.) * log(10.) / (1. + log(2. * M))); // n >= N
   N += N % 2; // N should be even
+  return N;
+}
+
+
+double DigitsOfPi(long n, long M, uint32_t *series_us, uint32_t *binomial_us)
+{
+  long N = BinomialTerms(n, M);
+  // too short a series makes N > n, and n-N must not be negative
+  while (N >= n) {
+    M += 2;
+    N = BinomialTerms(n, M);
+  }
   int64_t mmax = (int64_t)M * (int64_t)N + (int64_t)N;
+  uint32_t start_us = micros();
   double x = DigitsOfSeries(n, mmax);
-  for (long k = 0.; k < N; k++) {
-    int64_t m = (int64_t)2 * (int64_t)M * (int64_t)N + (int64_t)2 * (int64_t)k + 1;
-    InitializeModulo(m);
-    int64_t s = SumBinomialMod(N, k);
-    s = MulMod(s, PowMod(5, N));
-    s = MulMod(s, PowMod(10, n - N)); // n-N is always positive
-    s = MulMod(s, 4);
-    x += (2 * (k % 2) - 1) * (double)s / (double)m; // 2*(k%2)-1 = (-1)^(k-1)
-    x = x - floor(x);
+  uint32_t series_end_us = micros();
+  // 4*5^N*10^(n-N) = 4*5^n*2^(n-N), one chain; n-N is always positive
+  const PowChain scale(5, n, 2, n - N, 4);
+  const PowChain pow2N(2, N);
+  // moduli 2*M*N + 2*k + 1, by width as in DigitsOfSeries
+  int64_t base = (int64_t)2 * (int64_t)M * (int64_t)N + 1;
+  long k = 0;
+  long e = BinomialLimit(31, base) < N ? BinomialLimit(31, base) : N;
+  if (k < e) {
+    x += BinomialRange<Modulus<31>>(N, base, k, e, scale, pow2N);
+    k = e;
+  }
+  e = BinomialLimit(48, base) < N ? BinomialLimit(48, base) : N;
+  if (k < e) {
+    x += BinomialRange<Modulus<48>>(N, base, k, e, scale, pow2N);
+    k = e;
   }
+  if (k < N)
+    x += BinomialRange<Modulus<63>>(N, base, k, N, scale, pow2N);
+  x = x - floor(x);
+  if (series_us != nullptr)
+    *series_us = series_end_us - start_us;
+  if (binomial_us != nullptr)
+    *binomial_us = micros() - series_end_us;
   return x;
 }
+
+
+double DigitsOfPi(long n)
+{
+  return DigitsOfPi(n, SeriesLength(n));
+}
+
+
+long DigitsOfPiM(long n)
+{
+  return SeriesLength(n);
+}
+
+
+long DigitsOfPiN(long n, long M)
+{
+  return BinomialTerms(n, M);
+}
@@ -1,3 +1,35 @@
 #pragma once
 
+#include <Arduino.h>
+
 extern double DigitsOfPi(long n);
+
+// DigitsOfPi(n) splits its work between a series of about M*N terms and N
+// binomial sums. M = 2 * m_scale * (3n / log^3 n), and N follows from M.
+// Larger M means a longer series and fewer (cheaper) binomial sums. The
+// best m_scale depends on the relative cost of the two on a given CPU; the
+// PidecTune sketch measures it and prints a table for pidec_tune.cpp.
+struct PiTune {
+  long n_max;     // entry is for n <= n_max
+  float m_scale;
+};
+
+// compiled-in table for this CPU (pidec_tune.cpp), ends with n_max == 0
+extern const PiTune pi_tune[];
+
+// use a different table (e.g. one just measured)
+extern void DigitsOfPiTune(const PiTune *table);
+
+// M and N DigitsOfPi(n) would use
+extern long DigitsOfPiM(long n);
+extern long DigitsOfPiN(long n, long M);
+
+// DigitsOfPi with an explicit (even) M, optionally timing the two stages.
+// M is increased if needed to keep N < n.
+extern double DigitsOfPi(long n, long M, uint32_t *series_us=nullptr,
+                         uint32_t *binomial_us=nullptr);
+
+// Do moduli narrower than min_bits in a wider Modulus anyway (mulmod.h): 0
+// (the default) for the narrowest that fits, 48 or 63 to time the wider
+// kernels on the same work (MulModBench).
+extern void DigitsOfPiWidth(int min_bits);
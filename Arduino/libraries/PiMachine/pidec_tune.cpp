@@ -0,0 +1,14 @@
+#include <Arduino.h>
+#include <pidec.h>
+
+// M scale factors for DigitsOfPi, by CPU. These are printed by the
+// PidecTune sketch; paste its output here, in an #if for that CPU. A table
+// ends with n_max == 0. 1.0 is the original M = 2 * (3n / log^3 n).
+
+// Nothing is tuned yet. On the host (x86-64, with the width-specialized
+// modular arithmetic), PidecTune finds no M that beats the default by more
+// than run-to-run noise (under 1%), so the host uses the default too. The
+// devices haven't been measured.
+const PiTune pi_tune[] = {
+  { 0, 1.0f },
+};
@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include "chrono.h"
+#include "printer.h"
+#include "print_journal.h"
+
+
+PrintJournal::PrintJournal(Printer& printer, const Interval& line_time) :
+  confirmed(0),
+  dropped(0),
+  _printer(printer),
+  _line_time(line_time),
+  _first(0),
+  _count(0)
+{
+}
+
+
+bool PrintJournal::sent(int32_t pos)
+{
+  if (_count >= depth)
+    return false;
+  Entry& e = at(_count++);
+  e.pos = pos;
+  e.ticket = _printer.ticket();
+  e.sent = false;
+  update();
+  return true;
+}
+
+
+void PrintJournal::update()
+{
+  Time now = Time::now();
+  for (int i = 0; i < _count; i++) {
+    Entry& e = at(i);
+    if (e.sent)
+      continue;
+    if (!_printer.sent(e.ticket))
+      break; // the rest are behind it
+    // starts when the bytes are in, or when the line ahead is done
+    Time start = _printer_free < now ? now : _printer_free;
+    e.printed_at = start + _line_time;
+    e.sent = true;
+    _printer_free = e.printed_at;
+  }
+}
+
+
+Time PrintJournal::ready_at()
+{
+  update();
+  if (_count < depth)
+    return Time::now();
+  // full: room once the oldest is printed and confirmed; until its bytes are
+  // out there's no telling, so look again in a while
+  const Entry& e = at(0);
+  return e.sent ? e.printed_at : Time::now() + _line_time;
+}
+
+
+void PrintJournal::paper_ok(const Time& when)
+{
+  update();
+  while (_count > 0 && at(0).sent && !(when < at(0).printed_at)) {
+    _first = (_first + 1) % depth;
+    _count--;
+    confirmed++;
+  }
+}
+
+
+bool PrintJournal::check()
+{
+  _printer.poll();
+
+  const int reported = _printer.auto_paper();
+  if (reported == 0)
+    return false;
+  if (reported == 1 && Time::now() - _asked < Interval(confirm_ms)) {
+    paper_ok(Time::now() + Interval(-report_ms));
+    return true;
+  }
+
+  // Automatic status back on every time (if the printer has restarted,
+  // they've stopped, whatever the last one said); that also makes the last
+  // report unknown, so until a new one comes this asks again.
+  const Time asked;
+  _asked = asked;
+  _printer.auto_status(true);
+  if (!_printer.paper())
+    return false;
+  paper_ok(asked);
+  return true;
+}
+
+
+int32_t PrintJournal::oldest(int32_t next) const
+{
+  return _count > 0 ? at(0).pos : next;
+}
+
+
+void PrintJournal::clear()
+{
+  dropped += _count;
+  _first = 0;
+  _count = 0;
+}
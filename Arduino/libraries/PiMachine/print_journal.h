@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Arduino.h>
+#include "chrono.h"
+
+class Printer;
+
+// Lines sent to the printer that might not be on the paper yet.
+//
+// Each line is recorded with the position to come back to for it (the
+// sketch's digit number) and the printer ticket of its last byte. Once its
+// bytes have gone out, the printer is assumed to print lines one after
+// another, each taking at most line_time; and once the printer has said
+// there is paper at a time after that, the line is on the paper and is
+// forgotten. When the paper runs out (or the power), whatever is still
+// here is what might not have made it, so that is where to go back to
+// (oldest()), less a margin for the last bit of a roll not taking the ink.
+//
+// That is what lets lines go out as fast as the printer prints them,
+// rather than one per half second so that each is surely printed before
+// the paper is checked again.
+class PrintJournal {
+
+  public:
+
+    // Lines in flight at most, so the printer's buffer doesn't overflow and
+    // a rollback stays within the digit cache.
+    static const int depth = 8;
+
+    PrintJournal(Printer& printer, const Interval& line_time);
+
+    // A line went to the printer (just now, so its last byte is the
+    // printer's ticket()). False if there are already depth lines.
+    bool sent(int32_t pos);
+
+    // When there will be room for another line, if the estimate is right
+    // (now if there's room already).
+    Time ready_at();
+
+    // The printer said it had paper at 'when': either the answer to a
+    // status request sent then, or an automatic report that hasn't changed
+    // (less however long it might be on the way).
+    void paper_ok(const Time& when);
+
+    // Is there paper? If the printer sends automatic status reports
+    // (Printer::auto_status), the last one says; if not, ask it (several
+    // msec). Either way, a yes confirms what it can.
+    bool check();
+
+    // An automatic report about a change is on its way for at most this
+    // long (the printer's status latency, with lots of room).
+    static const int report_ms = 100;
+
+    // Ask anyway if it's been this long. A power blip shorter than a digit
+    // goes unnoticed, and the printer comes back without automatic status;
+    // its last report would say there's paper forever. Every ask turns
+    // automatic status back on, and only a report that comes after it is
+    // trusted, so lines confirmed on a stale report are the ones printed in
+    // this long: 4 at 250 msec a line, well inside the margin backing up
+    // after paper out leaves.
+    static const int confirm_ms = 1000;
+
+    // Position of the oldest line not known to be on the paper, or 'next'
+    // if there are none.
+    int32_t oldest(int32_t next) const;
+
+    // Forget everything (after going back to oldest()).
+    void clear();
+
+    int in_flight() const { return _count; }
+
+    // statistics
+    uint32_t confirmed;   // lines known to be on the paper
+    uint32_t dropped;     // lines cleared without being confirmed
+
+  private:
+
+    struct Entry {
+      int32_t pos;
+      uint32_t ticket;
+      bool sent;          // bytes all out, so printed_at is known
+      Time printed_at;    // printed by then, at the latest
+    };
+
+    Printer& _printer;
+    Interval _line_time;
+
+    Entry _entry[depth];
+    int _first;
+    int _count;
+
+    // when the newest line with known printed_at is printed
+    Time _printer_free;
+
+    // when check() last asked the printer
+    Time _asked;
+
+    // note lines whose bytes have gone out since last time
+    void update();
+
+    Entry& at(int i) { return _entry[(_first + i) % depth]; }
+    const Entry& at(int i) const { return _entry[(_first + i) % depth]; }
+};
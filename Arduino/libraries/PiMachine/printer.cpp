@@ -1,19 +1,69 @@
 
 #include <Arduino.h>
+#include <string.h>
+#include <chrono.h>
 #include <printer.h>
+#include <tx_queue.h>
 
 
-Printer::Printer(HardwareSerial& port) :
-  _port(port)
+Printer::Printer(HardwareSerial& port, TxQueue *tx) :
+  _port(port),
+  _tx(tx),
+  _asb_len(0),
+  _auto_paper(-1)
 {
 }
 
 
+void Printer::send(const void *buf, uint32_t len)
+{
+  if (_tx == nullptr) {
+    _port.write((const uint8_t *)buf, len);
+    return;
+  }
+
+  // The queue holds a dozen lines; this only waits if the printer has
+  // stopped taking bytes altogether (and then, like a full UART buffer
+  // used to, until it starts again). Anything bigger than the whole queue
+  // goes in pieces, waiting for room between them.
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    uint32_t n = len;
+    if (n > TxQueue::size)
+      n = TxQueue::size;
+    while (!_tx->queue(p, n, Time::now() + Interval(1000)))
+      ;
+    p += n;
+    len -= n;
+  }
+}
+
+
+bool Printer::sent()
+{
+  return _tx == nullptr || _tx->idle();
+}
+
+
+uint32_t Printer::ticket()
+{
+  return _tx != nullptr ? _tx->ticket() : 0;
+}
+
+
+bool Printer::sent(uint32_t ticket)
+{
+  return _tx == nullptr || _tx->done(ticket);
+}
+
+
 void Printer::begin(int baud)
 {
   _port.begin(baud);
   while (!_port)
     ;
+  if (_tx != nullptr)
+    _tx->begin();
   reset();
 }
 
@@ -21,7 +71,7 @@ void Printer::begin(int baud)
 void Printer::reset()
 {
   const uint8_t cmd[] = { 0x1b, 0x40 };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
 
 
@@ -37,33 +87,33 @@ bool Printer::paper()
 void Printer::rotate(bool rotate)
 {
   uint8_t cmd[] = { 0x1b, 0x56, uint8_t(rotate ? 0x01 : 0x00) };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
 
 
 void Printer::mode(uint8_t mode)
 {
   uint8_t cmd[] = { 0x1b, 0x21, mode };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
 
 
 void Printer::line_space(int dots)
 {
   uint8_t cmd[] = { 0x1b, 0x33, uint8_t(dots) };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
 
 
 void Printer::print(char c)
 {
-  _port.write(c);
+  send(&c, 1);
 }
 
 
 void Printer::print(const char *s)
 {
-  _port.write(s);
+  send(s, strlen(s));
 }
 
 
@@ -72,7 +122,7 @@ void Printer::flush(int dots)
   // print and advance a number of pixels, but always advance at least
   // the height of what's in the print buffer
   uint8_t cmd[] = { 0x1b, 0x4a, uint8_t(dots) };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
 
 
@@ -95,19 +145,14 @@ uint8_t Printer::status(int which)
 {
   const uint32_t timeout_us = 100000; // 100 msec
 
-  // read and discard any old data (usually none)
-  while (_port.read() != -1)
-    ;
-
   int b;
-  uint8_t cmd[] = { 0x10, 0x04, uint8_t(which) };
 
-  _port.write(cmd, sizeof(cmd));
+  status_request(which);
   uint32_t start_us = micros();
   do {
     // response_us is public member so we can see how long it took
     response_us = micros() - start_us;
-    b = _port.read();
+    b = status_response();
   } while (b == -1 && response_us <= timeout_us);
 
   if (b == -1)
@@ -117,8 +162,74 @@ uint8_t Printer::status(int which)
 }
 
 
+void Printer::status_request(int which)
+{
+  // The request goes to the back of the queue like anything else; let what's
+  // ahead of it go first, so the time to the response (and the timeout in
+  // status()) is the printer's and not the UART's.
+  if (_tx != nullptr)
+    _tx->flush(Time::now() + Interval(1000));
+
+  // read and discard any old data (usually none)
+  while (status_byte() != -1)
+    ;
+
+  uint8_t cmd[] = { 0x10, 0x04, uint8_t(which) };
+  send(cmd, sizeof(cmd));
+}
+
+
+int Printer::status_response()
+{
+  return status_byte();
+}
+
+
+void Printer::auto_status(bool on)
+{
+  // n: bit 3 is the paper sensor
+  uint8_t cmd[] = { 0x1d, 0x61, uint8_t(on ? 0x08 : 0x00) };
+  send(cmd, sizeof(cmd));
+  // unknown until the first report (or, when off, for good)
+  _auto_paper = -1;
+}
+
+
+void Printer::poll()
+{
+  // anything that isn't an automatic report is a late answer to a status
+  // request that status() gave up on
+  while (status_byte() != -1)
+    ;
+}
+
+
+// Status bytes are told apart by their fixed bits: a DLE EOT response is
+// 0xx1xx10, and the first byte of an automatic report is 0xx1xx00,
+// followed by three more. In the third, bits 2 and 3 are paper end.
+int Printer::status_byte()
+{
+  int b;
+  while ((b = _port.read()) != -1) {
+    if (_asb_len > 0) {
+      _asb[_asb_len++] = uint8_t(b);
+      if (_asb_len == 4) {
+        _auto_paper = (_asb[2] & 0x0c) == 0 ? 1 : 0;
+        _asb_len = 0;
+      }
+    } else if ((b & 0x93) == 0x10) {
+      _asb[0] = uint8_t(b);
+      _asb_len = 1;
+    } else {
+      return b;
+    }
+  }
+  return -1;
+}
+
+
 void Printer::heat(uint8_t n1, uint8_t n2, uint8_t n3)
 {
   uint8_t cmd[] = { 0x1b, 0x37, n1, n2, n3 };
-  _port.write(cmd, sizeof(cmd));
+  send(cmd, sizeof(cmd));
 }
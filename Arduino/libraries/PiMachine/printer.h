@@ -2,12 +2,17 @@
 
 #include <Arduino.h>
 
+class TxQueue;
+
 
 class Printer {
 
   public:
 
-    Printer(HardwareSerial& port);
+    // With a TxQueue (tx_queue.h), commands are queued for it to send in the
+    // background, and the calls below return without waiting for the UART.
+    // Status responses are read from the port either way.
+    Printer(HardwareSerial& port, TxQueue *tx=nullptr);
 
     void begin(int baud);
 
@@ -38,13 +43,47 @@ class Printer {
 
     uint8_t status(int which);
 
+    // status() in two halves, for polling: send the request, then look for
+    // the response (-1 until it arrives)
+    void status_request(int which);
+    int status_response();
+
+    // Automatic status back (GS a): with it on, the printer says when the
+    // paper runs out or comes back, without being asked. auto_paper() is
+    // what it last said: 1 paper, 0 no paper, -1 nothing yet (not on, or
+    // firmware that doesn't do it). The reports are read by poll(), and by
+    // status_response() on the way past.
+    void auto_status(bool on);
+    void poll();
+    int auto_paper() const { return _auto_paper; }
+
     void heat(uint8_t n1, uint8_t n2, uint8_t n3);
 
+    // True when everything written so far has gone out the port (always,
+    // without a TxQueue).
+    bool sent();
+
+    // The same for just what was written up to when ticket() was called,
+    // give or take the last two bytes still in the UART (see tx_queue.h).
+    uint32_t ticket();
+    bool sent(uint32_t ticket);
+
     // informational
     uint32_t response_us;
 
   private:
 
     HardwareSerial& _port;
+    TxQueue *_tx;
+
+    // automatic status back report being read (4 bytes)
+    uint8_t _asb[4];
+    int _asb_len;
+    int _auto_paper;
+
+    void send(const void *buf, uint32_t len);
+
+    // next status byte that isn't part of an automatic report, or -1
+    int status_byte();
 
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+// The Feather M4 Express's 2 MB QSPI flash as a FlashDev, using the Adafruit
+// SPIFlash library. This is header-only so that only sketches that include it
+// need that library. (The host simulator has its own qspi_flash.h.)
+
+#include <Arduino.h>
+#include <Adafruit_SPIFlash.h>
+#include "checkpoint.h"
+
+class QspiFlash : public FlashDev {
+
+  public:
+
+    QspiFlash() : _flash(&_transport) { }
+
+    bool begin() { return _flash.begin(); }
+
+    // bytes
+    uint32_t size() { return _flash.size(); }
+
+    virtual uint32_t sector_size() { return SFLASH_SECTOR_SIZE; }
+
+    virtual bool read(uint32_t addr, void *buf, uint32_t len)
+    {
+      return _flash.readBuffer(addr, (uint8_t *)buf, len) == len;
+    }
+
+    virtual bool program(uint32_t addr, const void *buf, uint32_t len)
+    {
+      return _flash.writeBuffer(addr, (const uint8_t *)buf, len) == len;
+    }
+
+    virtual bool erase(uint32_t addr)
+    {
+      return _flash.eraseSector(addr / SFLASH_SECTOR_SIZE);
+    }
+
+  private:
+
+    Adafruit_FlashTransport_QSPI _transport;
+    Adafruit_SPIFlash _flash;
+
+};
@@ -1,10 +1,15 @@
 #pragma once
 
 #include <Arduino.h>
+#include <chrono.h>
+#include <sched.h>
 
 // Common-Anode RGB LED (three GPIOs, low is on)
+//
+// An Rgb is a scheduler Source, so a Sched waiting on something else also
+// wakes up in time to blink the LED.
 
-class Rgb {
+class Rgb : public Source {
 
   public:
 
@@ -72,13 +77,13 @@ class Rgb {
     void loop()
     {
       if (_pat_num == 1) {
-        if (millis() < _next_ms)
+        if (int32_t(millis() - _next_ms) < 0)
           return;
         _pat_num = 2;
         _set(_rgb2);
         _next_ms += _ms2;
       } else if (_pat_num == 2) {
-        if (millis() < _next_ms)
+        if (int32_t(millis() - _next_ms) < 0)
           return;
         _pat_num = 1;
         _set(_rgb1);
@@ -86,6 +91,21 @@ class Rgb {
       }
     }
 
+    // Source: when the pattern next changes (if no pattern, an hour from
+    // now is as good as never)
+    virtual Time due() const
+    {
+      if (_pat_num == 0)
+        return Time::now() + Interval(3600000);
+      return Time::now() + Interval(int32_t(_next_ms - millis()));
+    }
+
+    virtual bool run()
+    {
+      loop();
+      return false;
+    }
+
   private:
 
     int _red_pin;
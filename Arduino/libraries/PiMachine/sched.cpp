@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <chrono.h>
+#include <sched.h>
+
+uint32_t Sched::slept_ms = 0;
+
+
+Sampler::Sampler(bool (*sample)(), const Interval& period) :
+  _sample(sample),
+  _period(period),
+  _level(false)
+{
+}
+
+
+void Sampler::begin()
+{
+  _level = _sample();
+  _changed = Time::now();
+  _next = _changed + _period;
+}
+
+
+bool Sampler::run()
+{
+  Time now = Time::now();
+  _next = now + _period;
+  bool level = _sample();
+  if (level == _level)
+    return false;
+  _level = level;
+  _changed = now;
+  return true;
+}
+
+
+bool Sched::add(Source& src)
+{
+  for (int i = 0; i < _num_sources; i++)
+    if (_sources[i] == &src)
+      return true;
+
+  if (_num_sources >= max_sources)
+    return false;
+
+  _sources[_num_sources++] = &src;
+  return true;
+}
+
+
+void Sched::remove(Source& src)
+{
+  for (int i = 0; i < _num_sources; i++) {
+    if (_sources[i] == &src) {
+      _sources[i] = _sources[--_num_sources];
+      return;
+    }
+  }
+}
+
+
+bool Sched::wait(const Time& until)
+{
+  while (true) {
+
+    Time now = Time::now();
+
+    bool wake = false;
+    for (int i = 0; i < _num_sources; i++)
+      if (!(now < _sources[i]->due()))
+        wake = _sources[i]->run() || wake;
+
+    if (wake)
+      return true;
+
+    if (!(now < until))
+      return false;
+
+    Time next = until;
+    for (int i = 0; i < _num_sources; i++)
+      if (_sources[i]->due() < next)
+        next = _sources[i]->due();
+
+    sleep_until(next);
+
+  } // while
+}
+
+
+void Sched::sleep_until(const Time& t)
+{
+  Time start = Time::now();
+
+  if (!(start < t))
+    return;
+
+  do {
+#if defined(__arm__)
+    // Sleep until the next interrupt. SysTick is one every millisecond, so
+    // this never oversleeps by more than that.
+    __asm__ volatile ("wfi");
+#else
+    yield();
+#endif
+  } while (Time::now() < t);
+
+  slept_ms += uint32_t((Time::now() - start).ms());
+}
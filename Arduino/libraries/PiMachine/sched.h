@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include <chrono.h>
+
+// Tiny cooperative scheduler, so waiting (for power, for paper, for the next
+// print slot) can sleep the core instead of spinning in yield() or delay(1).
+//
+// Things that need attention at some point in the future are Sources. Each
+// says when it next wants to run (due()), and run() does the work. Sched
+// runs whatever is due, then sleeps until the earliest due time. Any
+// interrupt wakes the core, and SysTick fires every millisecond, so sleeping
+// has millisecond resolution and is never late by more than that.
+
+
+// Something the scheduler can wait on.
+class Source {
+
+  public:
+
+    // when run() should next be called
+    virtual Time due() const = 0;
+
+    // Do whatever is needed. Return true if the code waiting in
+    // Sched::wait() should wake up (something changed).
+    virtual bool run() = 0;
+
+};
+
+
+// An input that is sampled periodically, e.g. an ADC compared against a
+// threshold, or the printer's paper sensor. run() returns true when the
+// sampled level changes.
+class Sampler : public Source {
+
+  public:
+
+    Sampler(bool (*sample)(), const Interval& period);
+
+    // sample now and start over
+    void begin();
+
+    // most recently sampled level
+    bool level() const { return _level; }
+
+    // when the level last changed (or begin() was called)
+    Time changed() const { return _changed; }
+
+    virtual Time due() const { return _next; }
+
+    virtual bool run();
+
+  private:
+
+    bool (*_sample)();
+    Interval _period;
+    Time _next;
+    Time _changed;
+    bool _level;
+
+};
+
+
+class Sched {
+
+  public:
+
+    Sched() : _num_sources(0) { }
+
+    // Sources are not owned; they must outlive the Sched (or be removed).
+    // Returns false if there is no room.
+    bool add(Source& src);
+    void remove(Source& src);
+
+    // Run any sources that are due, then sleep until the next one is due
+    // or until 'until', whichever is first. Returns true as soon as a source
+    // says to wake up, false when 'until' is reached.
+    bool wait(const Time& until);
+
+    // Sleep the core until t. With nothing else to do, this is how to wait.
+    static void sleep_until(const Time& t);
+
+    // informational: total milliseconds spent asleep
+    static uint32_t slept_ms;
+
+  private:
+
+    static const int max_sources = 6;
+    Source *_sources[max_sources];
+    int _num_sources;
+
+};
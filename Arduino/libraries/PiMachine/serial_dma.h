@@ -0,0 +1,112 @@
+#pragma once
+
+// TxQueue (tx_queue.h) drained by DMA straight into a SAMD21/SAMD51 UART,
+// using the Adafruit ZeroDMA library. Each transfer takes whatever is
+// contiguous at the front of the queue, one byte per TX-empty trigger, and
+// its completion interrupt starts the next. The CPU does nothing per byte,
+// and the sketch only ever copies into the queue.
+//
+// The port's begin() sets up the UART as usual, and reading (status
+// responses) still goes through it; only writing bypasses it. Nothing else
+// may write to the port while this is in use.
+//
+// This is header-only so that only sketches that include it need that
+// library. (The host simulator has its own serial_dma.h.)
+
+#include <Arduino.h>
+#include <Adafruit_ZeroDMA.h>
+#include "tx_queue.h"
+
+class SerialDma : public TxQueue {
+
+  public:
+
+    // sercom is the port's SERCOM and trigger its TX trigger, e.g. SERCOM5
+    // and SERCOM5_DMAC_ID_TX for Serial1 on the Feather M4. Only one
+    // SerialDma at a time.
+    SerialDma(Sercom *sercom, uint8_t trigger) :
+      _sercom(sercom),
+      _trigger(trigger),
+      _desc(nullptr),
+      _len(0),
+      _busy(false)
+    {
+    }
+
+    virtual bool begin()
+    {
+      if (_dma.allocate() != DMA_STATUS_OK)
+        return false;
+      _dma.setTrigger(_trigger);
+      _dma.setAction(DMA_TRIGGER_ACTON_BEAT);
+      // source and length are filled in for each transfer
+      const uint8_t *p;
+      front(&p);
+      _desc = _dma.addDescriptor((void *)p, (void *)&_sercom->USART.DATA.reg,
+                                 1, DMA_BEAT_SIZE_BYTE, true, false);
+      if (_desc == nullptr)
+        return false;
+      self() = this;
+      _dma.setCallback(transfer_done);
+      kick();
+      return true;
+    }
+
+  protected:
+
+    virtual void kick()
+    {
+      noInterrupts();
+      if (!_busy)
+        start();
+      interrupts();
+    }
+
+    // The DMA is done with a byte once it's in the UART's data register;
+    // TXC says the shift register has sent it too, with nothing after it.
+    // (TXC is clear until the first byte, so nothing queued yet is idle.)
+    virtual bool line_idle() const
+    {
+      return ticket() == 0 || _sercom->USART.INTFLAG.bit.TXC;
+    }
+
+  private:
+
+    Sercom *_sercom;
+    uint8_t _trigger;
+    Adafruit_ZeroDMA _dma;
+    DmacDescriptor *_desc;
+    volatile uint32_t _len;   // bytes in the transfer under way
+    volatile bool _busy;
+
+    // interrupts off, or in the DMA interrupt
+    void start()
+    {
+      if (_desc == nullptr)
+        return; // not begun; begin() kicks
+      const uint8_t *p;
+      uint32_t n = front(&p);
+      if (n == 0)
+        return;
+      _len = n;
+      _busy = true;
+      _dma.changeDescriptor(_desc, (void *)p, nullptr, n);
+      _dma.startJob();
+    }
+
+    // DMA interrupt
+    static void transfer_done(Adafruit_ZeroDMA *)
+    {
+      SerialDma *s = self();
+      s->pop(s->_len);
+      s->_busy = false;
+      s->start();
+    }
+
+    static SerialDma *& self()
+    {
+      static SerialDma *s = nullptr;
+      return s;
+    }
+
+};
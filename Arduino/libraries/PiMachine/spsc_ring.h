@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Fixed-size ring for one producer and one consumer, which may be different
+// threads (or an interrupt handler and the main loop) without a lock. Each
+// index is written by only one side; the other side reads it with acquire,
+// and it is published with release after the slot it covers is written or
+// read.
+//
+// N must be a power of two. The indices count up forever and wrap at 2^32,
+// which (with N a power of two) still indexes the right slot.
+template <typename T, uint32_t N>
+class SpscRing {
+
+    static_assert(N != 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+  public:
+
+    SpscRing() : _head(0), _tail(0) { }
+
+    static constexpr uint32_t capacity() { return N; }
+
+    // producer: false if full
+    bool push(const T& v)
+    {
+      uint32_t head = _head;
+      if (head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == N)
+        return false;
+      _buf[head % N] = v;
+      __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+      return true;
+    }
+
+    // consumer: the oldest entry, or nullptr if empty; it stays there
+    // until pop()
+    const T *front() const
+    {
+      uint32_t tail = _tail;
+      if (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail)
+        return nullptr;
+      return &_buf[tail % N];
+    }
+
+    // consumer: remove the oldest entry (there must be one)
+    void pop()
+    {
+      __atomic_store_n(&_tail, _tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // either side; only a snapshot if the other side is running
+    uint32_t size() const
+    {
+      return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) -
+             __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    }
+
+    bool full() const { return size() == N; }
+
+  private:
+
+    T _buf[N];
+    uint32_t _head;   // next to write; only the producer writes it
+    uint32_t _tail;   // next to read; only the consumer writes it
+
+};
@@ -0,0 +1,149 @@
+#include <Arduino.h>
+#include <string.h>
+#include "telemetry.h"
+
+Telemetry::Telemetry() :
+  saves(0),
+  failures(0),
+  _dev(nullptr),
+  _base(0),
+  _copy(0)
+{
+  reset();
+}
+
+
+void Telemetry::reset()
+{
+  memset(&_img, 0, sizeof(_img));
+  _img.magic = magic;
+  _img.version = version;
+  _img.buckets = num_buckets;
+  _last = Time::now();
+}
+
+
+bool Telemetry::begin(FlashDev& dev, uint32_t base, uint32_t size)
+{
+  _dev = &dev;
+  _base = base;
+  _copy = 0;
+  reset();
+
+  uint32_t sector = dev.sector_size();
+  if (sector == 0 || base % sector != 0 || size < region_size(sector))
+    return false;
+  _copy = region_size(sector) / 2;
+
+  // the newer of the two, if either is any good (one at a time; they're
+  // big for the stack)
+  uint32_t best = 0;
+  for (int i = 0; i < 2; i++) {
+    if (load(_base + i * _copy, _img) && _img.seq > best)
+      best = _img.seq;
+  }
+  for (int i = 0; i < 2 && best != 0; i++) {
+    if (load(_base + i * _copy, _img) && _img.seq == best)
+      break;
+  }
+  if (best == 0)
+    reset();
+
+  _last = Time::now();
+  return true;
+}
+
+
+bool Telemetry::load(uint32_t addr, Image& img)
+{
+  return _dev->read(addr, &img, sizeof(img)) && valid(img);
+}
+
+
+Telemetry::Bucket& Telemetry::at(int32_t pos)
+{
+  Time now = Time::now();
+  _img.run_ms += uint64_t((now - _last).ms());
+  _last = now;
+
+  Bucket& b = _img.bucket[bucket(pos < 0 ? 0 : pos)];
+  decay_to(b, uint32_t(_img.run_ms / 60000));
+  return b;
+}
+
+
+void Telemetry::digit(int32_t pos, const Interval& cost)
+{
+  Bucket& b = at(pos);
+  float s = float(cost.ms()) * 0.001f;
+  b.digits += 1.0f;
+  b.compute_s += s;
+  b.compute_s2 += s * s;
+}
+
+
+void Telemetry::wait(int32_t pos, Wait what, const Interval& waited, int32_t back_up)
+{
+  Bucket& b = at(pos);
+  float s = float(waited.ms()) * 0.001f;
+  if (what == Power)
+    b.power_s += s;
+  else
+    b.paper_s += s;
+  b.outs += 1.0f;
+  b.backed_up += float(back_up);
+}
+
+
+bool Telemetry::save()
+{
+  if (_dev == nullptr || _copy == 0) {
+    failures++;
+    return false;
+  }
+
+  Time now = Time::now();
+  _img.run_ms += uint64_t((now - _last).ms());
+  _last = now;
+
+  // the copy that isn't the newest one (seq goes to the copy it's odd or
+  // even for, so that's the one the last save didn't use)
+  _img.seq++;
+  _img.crc = crc(_img);
+  const uint32_t addr = _base + (_img.seq % 2) * _copy;
+
+  const uint32_t sector = _dev->sector_size();
+  bool ok = true;
+  for (uint32_t off = 0; off < _copy && ok; off += sector)
+    ok = _dev->erase(addr + off);
+
+  // a page at a time
+  const uint8_t *p = (const uint8_t *)&_img;
+  for (uint32_t off = 0; off < sizeof(_img) && ok; off += CheckpointStore::slot_size) {
+    uint32_t len = sizeof(_img) - off;
+    if (len > CheckpointStore::slot_size)
+      len = CheckpointStore::slot_size;
+    ok = _dev->program(addr + off, p + off, len);
+  }
+
+  // read it back, a piece at a time, against the CRC
+  uint32_t crc = 0;
+  uint8_t buf[64];
+  for (uint32_t off = crc_from; off < sizeof(_img) && ok; off += sizeof(buf)) {
+    uint32_t len = sizeof(_img) - off;
+    if (len > sizeof(buf))
+      len = sizeof(buf);
+    ok = _dev->read(addr + off, buf, len);
+    crc = crc32(crc, buf, len);
+  }
+  ok = ok && crc == _img.crc;
+
+  if (ok) {
+    saves++;
+  } else {
+    // try that copy again next time, not the one with the newest image
+    _img.seq--;
+    failures++;
+  }
+  return ok;
+}
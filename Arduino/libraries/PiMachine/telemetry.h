@@ -0,0 +1,162 @@
+#pragma once
+
+#include <Arduino.h>
+#include <math.h>
+#include "checkpoint.h"
+#include "chrono.h"
+
+// How long digits take to compute, how long the machine waits for power and
+// paper, and how often it backs up, over the whole run, by digit position.
+//
+// Positions go in log-spaced buckets, per_octave of them for each power of
+// two (so each covers about 9% more of n than the one before), which is
+// num_buckets for any position there can be: the memory (and the flash it
+// is saved to) stays the same however long the machine runs. A bucket holds
+// sums (digits computed, seconds it took, ...) that decay with a half-life
+// of half_life_min minutes of running. Positions are only computed again
+// after going back to the start, but when that happens (a new engine, say)
+// the bucket follows the new costs rather than averaging in the old ones;
+// the ratios (average cost) don't decay.
+//
+// The sums are saved to flash now and then, alternately in two copies so a
+// save cut short leaves the other; begin() loads the newer valid one. The
+// image is plain data, so Host/pitelemetry can read it from a flash image or
+// a dump (the TelemetryDump sketch) and turn it into a cost-versus-n curve.
+class Telemetry {
+
+  public:
+
+    static const int per_octave = 8;
+
+    // positions 0 .. per_octave - 1 get a bucket each, then per_octave per
+    // power of two up to 2^31
+    static const int num_buckets = per_octave * (31 - 3 + 1);
+
+    static const uint32_t half_life_min = 30 * 24 * 60;
+
+    struct Bucket {
+      uint32_t stamp_min; // run minutes the sums were decayed to
+      float digits;       // digits computed (not looked up or reprinted)
+      float compute_s;    // seconds computing them
+      float compute_s2;   // sum of their squares
+      float power_s;      // seconds waiting for power
+      float paper_s;      // seconds waiting for paper (and any power out
+                          // while waiting)
+      float outs;         // power and paper outs
+      float backed_up;    // digits gone back over after them
+    };
+
+    struct Image {
+      uint32_t magic;
+      uint32_t crc;         // of the rest, from seq
+      uint32_t seq;         // saves, counting this one
+      uint16_t version;
+      uint16_t buckets;     // num_buckets
+      uint64_t run_ms;      // time running (not off), over every run
+      Bucket bucket[num_buckets];
+    };
+
+    static const uint32_t magic = 0x6d546950; // "PiTm"
+    static const uint16_t version = 1;
+
+    // Flash to give begin(): two copies, each a whole number of sectors.
+    static uint32_t region_size(uint32_t sector_size)
+    {
+      uint32_t copy = (sizeof(Image) + sector_size - 1) / sector_size * sector_size;
+      return 2 * copy;
+    }
+
+    // bucket for position pos (>= 0), and the first position in bucket b
+    // (bucket_lo(b + 1) is one past its last)
+    static int bucket(int32_t pos)
+    {
+      if (pos < per_octave)
+        return int(pos);
+      int msb = 31 - __builtin_clz(uint32_t(pos));
+      return per_octave * (msb - 2) + int((uint32_t(pos) >> (msb - 3)) & (per_octave - 1));
+    }
+
+    static int64_t bucket_lo(int b)
+    {
+      if (b < per_octave)
+        return b;
+      int msb = b / per_octave + 2;
+      return int64_t(per_octave + b % per_octave) << (msb - 3);
+    }
+
+    // how much a sum shrinks from run minute 'from' to 'to'
+    static float decay(uint32_t from, uint32_t to)
+    {
+      return to > from ? exp2f(-float(to - from) / float(half_life_min)) : 1.0f;
+    }
+
+    // Bring b's sums to run minute 'now'.
+    static void decay_to(Bucket& b, uint32_t now)
+    {
+      if (now <= b.stamp_min)
+        return;
+      float f = decay(b.stamp_min, now);
+      b.digits *= f;
+      b.compute_s *= f;
+      b.compute_s2 *= f;
+      b.power_s *= f;
+      b.paper_s *= f;
+      b.outs *= f;
+      b.backed_up *= f;
+      b.stamp_min = now;
+    }
+
+    // the CRC starts after the crc field
+    static const uint32_t crc_from = 2 * sizeof(uint32_t);
+
+    static uint32_t crc(const Image& img)
+    {
+      return crc32(0, (const uint8_t *)&img + crc_from, sizeof(img) - crc_from);
+    }
+
+    // whether img is a complete, valid image of this version
+    static bool valid(const Image& img)
+    {
+      return img.magic == magic && img.version == version &&
+             img.buckets == num_buckets && img.seq != 0 &&
+             img.seq != 0xffffffff && crc(img) == img.crc;
+    }
+
+    Telemetry();
+
+    // Use bytes [base, base + size) of the flash (see region_size) and load
+    // the newer saved image there, if there is one. False if the region is
+    // no good; everything is still recorded, but not saved.
+    bool begin(FlashDev& dev, uint32_t base, uint32_t size);
+
+    // Digit pos was computed, taking 'cost'.
+    void digit(int32_t pos, const Interval& cost);
+
+    enum Wait { Power, Paper };
+
+    // Waited at pos for power or paper, then went back 'back_up' digits.
+    void wait(int32_t pos, Wait what, const Interval& waited, int32_t back_up);
+
+    // Save to flash (the older copy); false if it couldn't be written and
+    // read back.
+    bool save();
+
+    const Image& image() const { return _img; }
+
+    // since begin()
+    uint32_t saves;
+    uint32_t failures;
+
+  private:
+
+    Image _img;
+    Time _last;         // run_ms is up to here
+
+    FlashDev *_dev;
+    uint32_t _base;
+    uint32_t _copy;     // bytes per copy, 0 if not saving
+
+    void reset();
+    Bucket& at(int32_t pos);
+    bool load(uint32_t addr, Image& img);
+};
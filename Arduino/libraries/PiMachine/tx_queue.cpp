@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include <string.h>
+#include "chrono.h"
+#include "sched.h"
+#include "tx_queue.h"
+
+
+TxQueue::TxQueue() :
+  high_water(0),
+  waits(0),
+  _head(0),
+  _tail(0)
+{
+}
+
+
+bool TxQueue::queue(const void *buf, uint32_t len)
+{
+  uint32_t head = _head;
+  uint32_t used = head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+  if (len > size - used)
+    return false;
+
+  // in at most two pieces, around the end of the ring
+  const uint8_t *src = (const uint8_t *)buf;
+  uint32_t at = head % size;
+  uint32_t first = len < size - at ? len : size - at;
+  memcpy(_buf + at, src, first);
+  memcpy(_buf, src + first, len - first);
+
+  __atomic_store_n(&_head, head + len, __ATOMIC_RELEASE);
+
+  if (used + len > high_water)
+    high_water = used + len;
+
+  kick();
+  return true;
+}
+
+
+bool TxQueue::queue(const void *buf, uint32_t len, const Time& until)
+{
+  if (queue(buf, len))
+    return true;
+  if (len > size)
+    return false;
+  waits++;
+  do {
+    if (!(Time::now() < until))
+      return false;
+    // a byte is under a millisecond even at 9600 baud
+    Sched::sleep_until(Time::now() + Interval(1));
+  } while (!queue(buf, len));
+  return true;
+}
+
+
+bool TxQueue::wait(uint32_t ticket, const Time& until)
+{
+  while (!done(ticket)) {
+    if (!(Time::now() < until))
+      return false;
+    Sched::sleep_until(Time::now() + Interval(1));
+  }
+  return true;
+}
+
+
+bool TxQueue::flush(const Time& until)
+{
+  while (!idle()) {
+    if (!(Time::now() < until))
+      return false;
+    Sched::sleep_until(Time::now() + Interval(1));
+  }
+  return true;
+}
+
+
+uint32_t TxQueue::front(const uint8_t **p) const
+{
+  uint32_t tail = _tail;
+  uint32_t n = __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - tail;
+  uint32_t at = tail % size;
+  if (n > size - at)
+    n = size - at;
+  *p = _buf + at;
+  return n;
+}
+
+
+void TxQueue::pop(uint32_t n)
+{
+  __atomic_store_n(&_tail, _tail + n, __ATOMIC_RELEASE);
+}
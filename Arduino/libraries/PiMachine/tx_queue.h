@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+#include "chrono.h"
+
+// Bytes on their way out of a serial port, for a transport that moves them
+// in the background (DMA, or a TX-empty interrupt) so that writing never
+// waits for the UART. At 19200 baud a printed line is 20 msec of shifting
+// bits; through HardwareSerial::write, that is 20 msec the sketch can't
+// spend computing once the core's small buffer is full.
+//
+// One producer (the sketch) and one consumer (the transport, usually in an
+// interrupt handler), without a lock, the same way as SpscRing. Commands
+// go in whole: queue() takes all of a buffer or none of it, so a printer
+// command never goes out half now and half later.
+//
+// Completion: every byte ever queued has a number, counting from 1;
+// ticket() is the number of the last one queued so far, and done(t) says
+// whether byte t has been handed to the hardware. That's not quite the same
+// as sent: the UART may still be shifting it out (and the byte before it),
+// up to two byte times (1 msec at 19200 baud). idle() also asks the
+// transport whether the last byte has left the UART.
+class TxQueue {
+
+  public:
+
+    TxQueue();
+
+    // Get the transport going (after the port's begin()).
+    virtual bool begin() { return true; }
+
+    // Producer: all of buf, or false (and none of it) if there isn't room.
+    bool queue(const void *buf, uint32_t len);
+
+    // Producer: queue, sleeping until there's room or 'until' (false). More
+    // than size bytes never fit, so that's false right away.
+    bool queue(const void *buf, uint32_t len, const Time& until);
+
+    uint32_t ticket() const { return _head; }
+
+    bool done(uint32_t ticket) const
+    {
+      return int32_t(__atomic_load_n(&_tail, __ATOMIC_ACQUIRE) - ticket) >= 0;
+    }
+
+    // everything queued has been handed off, and the last of it sent
+    bool idle() const { return done(_head) && line_idle(); }
+
+    // Sleep until byte 'ticket' has been handed off, or 'until' (false).
+    bool wait(uint32_t ticket, const Time& until);
+
+    // Sleep until idle(), or 'until' (false).
+    bool flush(const Time& until);
+
+    static const uint32_t size = 1024;
+
+    // statistics
+    uint32_t high_water;  // most ever queued
+    uint32_t waits;       // queue() calls that had to wait for room
+
+  protected:
+
+    // Consumer: the oldest queued bytes that are contiguous in the ring
+    // (what one DMA transfer can take), and how many; 0 if none.
+    uint32_t front(const uint8_t **p) const;
+
+    // Consumer: those bytes (n of them) have gone out.
+    void pop(uint32_t n);
+
+    // Producer, after queueing: start moving bytes out if the transport is
+    // idle. (If it's busy, it carries on to the new bytes when it's done.)
+    virtual void kick() = 0;
+
+    // Whether the UART has finished sending the last byte it was given. The
+    // default is for transports that only pop a byte once it has gone.
+    virtual bool line_idle() const { return true; }
+
+  private:
+
+    uint8_t _buf[size];
+    uint32_t _head;   // bytes ever queued; only the producer writes it
+    uint32_t _tail;   // bytes ever sent; only the consumer writes it
+
+};
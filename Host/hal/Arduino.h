@@ -0,0 +1,150 @@
+#pragma once
+
+// Just enough of the Arduino API to build the sketches and libraries on a
+// Linux host. Time is virtual (see hal.h): it advances by (scaled) host time
+// while the sketch computes, and jumps ahead whenever the sketch waits
+// (delay(), yield(), WFI), so waiting is free and weeks of operation can be
+// simulated in seconds.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define HOST_HAL 1
+
+#define LOW 0
+#define HIGH 1
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define LED_BUILTIN 13
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+int analogRead(int pin);
+int digitalRead(int pin);
+void digitalWrite(int pin, int val);
+void pinMode(int pin, int mode);
+
+extern "C" void SysTick_DefaultHandler(void);
+
+
+class Print {
+
+  public:
+
+    virtual ~Print() { }
+
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len);
+
+    size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+    size_t write(const char *buf, size_t len) { return write((const uint8_t *)buf, len); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write(uint8_t(c)); }
+    size_t print(unsigned char n, int base=DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base=DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base=DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base=DEC);
+    size_t print(unsigned long n, int base=DEC);
+    size_t print(long long n, int base=DEC);
+    size_t print(unsigned long long n, int base=DEC);
+    size_t print(double n, int digits=2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+
+};
+
+
+class Stream : public Print {
+
+  public:
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+};
+
+
+// Where the bytes of a serial port actually go (console, printer emulator).
+class SerialDevice {
+
+  public:
+
+    virtual ~SerialDevice() { }
+
+    // bytes from the sketch
+    virtual void rx(uint8_t b) = 0;
+
+    // bytes to the sketch (-1 if none)
+    virtual int tx_peek() { return -1; }
+    virtual int tx_read() { return -1; }
+
+    // false if the device is not connected (e.g. no console host)
+    virtual bool connected() { return true; }
+
+};
+
+
+class HardwareSerial : public Stream {
+
+  public:
+
+    HardwareSerial() : _dev(nullptr), _baud(0) { }
+
+    void begin(unsigned long baud) { _baud = baud; }
+    void end() { }
+
+    operator bool() { return _dev == nullptr || _dev->connected(); }
+
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *buf, size_t len);
+    using Print::write;
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+
+    int availableForWrite();
+    void flush() { }
+
+    // host only
+    void attach(SerialDevice *dev) { _dev = dev; }
+    unsigned long baud() const { return _baud; }
+
+  private:
+
+    SerialDevice *_dev;
+    unsigned long _baud;
+
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+
+// sketch entry points
+void setup();
+void loop();
@@ -0,0 +1,88 @@
+#include <Arduino.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "hal.h"
+#include "file_sink.h"
+
+static const char *digits_path = nullptr;
+
+
+namespace hal {
+
+void set_digits_file(const char *path)
+{
+  digits_path = path;
+}
+
+} // namespace hal
+
+
+FileSink::FileSink() :
+  _fd(-1),
+  _len(0),
+  _off(0)
+{
+}
+
+
+FileSink::~FileSink()
+{
+  if (_fd >= 0)
+    close(_fd);
+}
+
+
+bool FileSink::enabled() const
+{
+  return digits_path != nullptr;
+}
+
+
+bool FileSink::write(const DigitRecord& r)
+{
+  if (digits_path == nullptr)
+    return true; // nowhere to go; don't hold anything up
+
+  if (_fd < 0) {
+    // a reader that goes away should be EPIPE, not the end of the program
+    signal(SIGPIPE, SIG_IGN);
+    // a pipe with no reader yet fails with ENXIO; try again next time
+    _fd = open(digits_path, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK, 0644);
+    if (_fd < 0)
+      return false;
+  }
+
+  // finish the previous line first
+  if (_off < _len && !send())
+    return false;
+
+  _len = snprintf(_buf, sizeof(_buf), "%ld %c %lld\n", (long)r.num, r.digit,
+                  (long long)r.elapsed_ms);
+  _off = 0;
+  send();
+  // Taken, even if only partly written; the rest goes before the next.
+  return true;
+}
+
+
+// write what's left of _buf; true if it all went
+bool FileSink::send()
+{
+  while (_off < _len) {
+    ssize_t n = ::write(_fd, _buf + _off, _len - _off);
+    if (n < 0) {
+      if (errno == EPIPE) {
+        // reader went away; reopen later
+        close(_fd);
+        _fd = -1;
+        _off = _len = 0;
+      }
+      return false;
+    }
+    _off += int(n);
+  }
+  return true;
+}
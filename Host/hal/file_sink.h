@@ -0,0 +1,35 @@
+#pragma once
+
+// Host only: digits to a file or named pipe, one per line as
+//   <num> <digit> <elapsed ms>
+// The path comes from hal::set_digits_file() (the simulator's --digits). A
+// pipe is opened non-blocking; until something opens the other end, or
+// while it isn't keeping up, write() says no and the queue's policy
+// decides what happens.
+
+#include <Arduino.h>
+#include <digit_sink.h>
+
+class FileSink : public DigitSink {
+
+  public:
+
+    FileSink();
+    ~FileSink();
+
+    // false if no file was asked for
+    bool enabled() const;
+
+    virtual bool write(const DigitRecord& r);
+
+  private:
+
+    int _fd;
+
+    // the rest of a line the pipe only took part of
+    char _buf[48];
+    int _len;
+    int _off;
+
+    bool send();
+};
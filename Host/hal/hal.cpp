@@ -0,0 +1,332 @@
+#include <Arduino.h>
+#include <time.h>
+#include "hal.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+static const int num_pins = 64;
+static int analog_in[num_pins];
+static int digital_in[num_pins];
+
+static uint64_t start_ms = 0;
+static uint64_t virt_us = 0;
+static double cpu_scale = 1.0;
+static uint32_t poll_us = 1;
+
+static uint64_t host_ns_last = 0;
+
+static void (*time_hook)(uint64_t now_us) = nullptr;
+static void (*output_hook)(int pin, int value) = nullptr;
+
+static const int max_peripherals = 4;
+static hal::Peripheral *peripherals[max_peripherals];
+static int num_peripherals = 0;
+
+
+// Wall-clock rather than CPU time: the CPU-time clocks are a system call
+// each, and the HAL reads this very often.
+static uint64_t host_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+
+// Charge the host time used since the last call to virtual time. On the
+// way there, stop for whatever peripherals want to run.
+static void sync(uint64_t extra_us)
+{
+  uint64_t ns = host_ns();
+  uint64_t to = virt_us + extra_us;
+  if (host_ns_last != 0 && cpu_scale > 0.)
+    to += uint64_t(double(ns - host_ns_last) * cpu_scale / 1000.);
+  host_ns_last = ns;
+
+  while (true) {
+    hal::Peripheral *next = nullptr;
+    uint64_t t = to;
+    for (int i = 0; i < num_peripherals; i++) {
+      uint64_t due = peripherals[i]->due_us();
+      if (due <= t) {
+        t = due;
+        next = peripherals[i];
+      }
+    }
+    if (next == nullptr)
+      break;
+    if (t > virt_us) {
+      virt_us = t;
+      if (time_hook != nullptr)
+        time_hook(virt_us);
+    }
+    next->run();
+  }
+
+  virt_us = to;
+
+  if (time_hook != nullptr)
+    time_hook(virt_us);
+}
+
+
+namespace hal {
+
+uint64_t now_us()
+{
+  return virt_us;
+}
+
+
+uint64_t now_ms()
+{
+  return start_ms + virt_us / 1000;
+}
+
+
+void advance_us(uint64_t us)
+{
+  sync(us);
+}
+
+
+void skip_host_time()
+{
+  host_ns_last = host_ns();
+}
+
+
+void set_cpu_scale(double scale)
+{
+  cpu_scale = scale;
+}
+
+
+void set_start_ms(uint64_t ms)
+{
+  start_ms = ms;
+}
+
+
+void set_poll_us(uint32_t us)
+{
+  poll_us = us;
+}
+
+
+void set_time_hook(void (*hook)(uint64_t now_us))
+{
+  time_hook = hook;
+}
+
+
+void add_peripheral(Peripheral *p)
+{
+  if (num_peripherals < max_peripherals)
+    peripherals[num_peripherals++] = p;
+}
+
+
+void set_analog(int pin, int value)
+{
+  if (0 <= pin && pin < num_pins)
+    analog_in[pin] = value;
+}
+
+
+void set_digital(int pin, int value)
+{
+  if (0 <= pin && pin < num_pins)
+    digital_in[pin] = value;
+}
+
+
+void set_output_hook(void (*hook)(int pin, int value))
+{
+  output_hook = hook;
+}
+
+} // namespace hal
+
+
+uint32_t millis()
+{
+  sync(poll_us);
+  return uint32_t(start_ms + virt_us / 1000);
+}
+
+
+uint32_t micros()
+{
+  sync(poll_us);
+  return uint32_t((start_ms * 1000) + virt_us);
+}
+
+
+void delay(uint32_t ms)
+{
+  sync(uint64_t(ms) * 1000);
+}
+
+
+void delayMicroseconds(uint32_t us)
+{
+  sync(us);
+}
+
+
+// On the device, waiting loops either call yield() or sleep until the next
+// interrupt (at least once per millisecond). Either way, here that is the
+// rest of the current millisecond.
+void yield()
+{
+  sync(1000 - (start_ms * 1000 + virt_us) % 1000);
+}
+
+
+// Millis64Test calls this to run millis() up to the rollover quickly.
+extern "C" void SysTick_DefaultHandler(void)
+{
+  sync(1000);
+}
+
+
+int analogRead(int pin)
+{
+  sync(poll_us);
+  if (0 <= pin && pin < num_pins)
+    return analog_in[pin];
+  return 0;
+}
+
+
+int digitalRead(int pin)
+{
+  sync(poll_us);
+  if (0 <= pin && pin < num_pins)
+    return digital_in[pin];
+  return 0;
+}
+
+
+void digitalWrite(int pin, int val)
+{
+  if (output_hook != nullptr)
+    output_hook(pin, val);
+}
+
+
+void pinMode(int pin, int mode)
+{
+  if (mode == INPUT_PULLUP && 0 <= pin && pin < num_pins)
+    digital_in[pin] = 1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Print
+
+
+size_t Print::write(const uint8_t *buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    write(buf[i]);
+  return len;
+}
+
+
+size_t Print::print(long n, int base)
+{
+  if (n < 0 && base == DEC)
+    return print('-') + print((unsigned long)(-n), base);
+  return print((unsigned long)n, base);
+}
+
+
+size_t Print::print(unsigned long n, int base)
+{
+  return print((unsigned long long)n, base);
+}
+
+
+size_t Print::print(long long n, int base)
+{
+  if (n < 0 && base == DEC)
+    return print('-') + print((unsigned long long)(-n), base);
+  return print((unsigned long long)n, base);
+}
+
+
+size_t Print::print(unsigned long long n, int base)
+{
+  char buf[65];
+  char *p = buf + sizeof(buf) - 1;
+  *p = '\0';
+  if (base < 2)
+    base = DEC;
+  do {
+    int d = int(n % base);
+    *--p = char(d < 10 ? '0' + d : 'A' + d - 10);
+    n /= base;
+  } while (n != 0);
+  return write(p);
+}
+
+
+size_t Print::print(double n, int digits)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// HardwareSerial
+
+
+size_t HardwareSerial::write(uint8_t b)
+{
+  if (_dev != nullptr)
+    _dev->rx(b);
+  else
+    fputc(b, stdout);
+  return 1;
+}
+
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+  if (_dev == nullptr)
+    return fwrite(buf, 1, len, stdout);
+  for (size_t i = 0; i < len; i++)
+    _dev->rx(buf[i]);
+  return len;
+}
+
+
+int HardwareSerial::available()
+{
+  sync(poll_us);
+  return (_dev != nullptr && _dev->tx_peek() != -1) ? 1 : 0;
+}
+
+
+int HardwareSerial::read()
+{
+  sync(poll_us);
+  return _dev != nullptr ? _dev->tx_read() : -1;
+}
+
+
+int HardwareSerial::peek()
+{
+  return _dev != nullptr ? _dev->tx_peek() : -1;
+}
+
+
+int HardwareSerial::availableForWrite()
+{
+  return (_dev == nullptr || _dev->connected()) ? 256 : 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Control side of the host HAL: the simulator uses this to drive virtual
+// time and the inputs the sketch sees. Sketches only see Arduino.h.
+
+#include <stdint.h>
+
+namespace hal {
+
+// Virtual microseconds since the simulated boot. The low 32 bits of
+// now_us() / 1000 are what millis() returns (after adding start_ms).
+uint64_t now_us();
+
+// Virtual milliseconds as millis() would see them without wrapping, i.e.
+// start_ms + elapsed. (now_ms() >> 32) is the number of millis() rollovers.
+uint64_t now_ms();
+
+// Move virtual time forward (the sketch is waiting).
+void advance_us(uint64_t us);
+
+// Virtual time added per host second while the sketch computes. 1.0
+// runs at host speed; larger numbers emulate a slower CPU. 0 makes
+// computing free (and the simulation deterministic).
+void set_cpu_scale(double scale);
+
+// millis() value at boot; set it near 2^32 to reach the rollover quickly
+void set_start_ms(uint64_t ms);
+
+// Don't charge the host time since the last HAL call to virtual time; for
+// host work the device doesn't do (e.g. the flash stand-in's file I/O).
+void skip_host_time();
+
+// Virtual time each millis()/micros() call costs, so busy-wait loops
+// terminate. Default is 1 usec.
+void set_poll_us(uint32_t us);
+
+// Called (from whatever HAL call the sketch happened to make) each time
+// virtual time moves. The simulator uses it to apply scripted events and to
+// decide when to stop.
+void set_time_hook(void (*hook)(uint64_t now_us));
+
+// Something on the device that gets on with its work while the sketch
+// computes, and interrupts it at times of its own (e.g. the UART under
+// SerialDma). As virtual time moves, it stops at each peripheral's due_us()
+// on the way, in order, and calls run() there.
+class Peripheral {
+
+  public:
+
+    // virtual time run() is next wanted (UINT64_MAX for not at all)
+    virtual uint64_t due_us() = 0;
+
+    // do it; must move due_us() on
+    virtual void run() = 0;
+
+};
+
+// Peripherals aren't owned; they must outlive the run.
+void add_peripheral(Peripheral *p);
+
+// inputs
+void set_analog(int pin, int value);
+void set_digital(int pin, int value);
+
+// Called when the sketch writes a digital output.
+void set_output_hook(void (*hook)(int pin, int value));
+
+// File that holds the contents of the QSPI flash (qspi_flash.h) between
+// runs; without one the flash starts erased every time.
+void set_flash_file(const char *path);
+
+// File or named pipe for FileSink (file_sink.h) to write digits to.
+void set_digits_file(const char *path);
+
+} // namespace hal
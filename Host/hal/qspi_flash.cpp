@@ -0,0 +1,107 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "qspi_flash.h"
+
+static const char *flash_path = nullptr;
+
+
+namespace hal {
+
+void set_flash_file(const char *path)
+{
+  flash_path = path;
+}
+
+} // namespace hal
+
+
+QspiFlash::QspiFlash() :
+  _mem(nullptr),
+  _file(nullptr)
+{
+}
+
+
+QspiFlash::~QspiFlash()
+{
+  if (_file != nullptr)
+    fclose(_file);
+  delete[] _mem;
+}
+
+
+bool QspiFlash::begin()
+{
+  hal::skip_host_time();
+
+  if (_mem == nullptr)
+    _mem = new uint8_t[flash_size];
+  memset(_mem, 0xff, flash_size);
+
+  if (flash_path == nullptr)
+    return true;
+
+  size_t n = 0;
+  _file = fopen(flash_path, "r+b");
+  if (_file != nullptr) {
+    n = fread(_mem, 1, flash_size, _file);
+  } else {
+    _file = fopen(flash_path, "w+b");
+    if (_file == nullptr)
+      return false;
+  }
+  // new (or short) file: the rest is erased
+  if (n < flash_size)
+    store(n, flash_size - n);
+  hal::skip_host_time();
+  return true;
+}
+
+
+bool QspiFlash::read(uint32_t addr, void *buf, uint32_t len)
+{
+  // a QSPI read is quick, but it isn't free
+  delayMicroseconds(1 + len / 16);
+  if (_mem == nullptr || addr > flash_size || len > flash_size - addr)
+    return false;
+  memcpy(buf, _mem + addr, len);
+  return true;
+}
+
+
+bool QspiFlash::program(uint32_t addr, const void *buf, uint32_t len)
+{
+  delayMicroseconds(700); // page program time
+  if (_mem == nullptr || addr > flash_size || len > flash_size - addr)
+    return false;
+  const uint8_t *b = (const uint8_t *)buf;
+  for (uint32_t i = 0; i < len; i++)
+    _mem[addr + i] &= b[i];
+  store(addr, len);
+  return true;
+}
+
+
+bool QspiFlash::erase(uint32_t addr)
+{
+  delay(45); // sector erase time
+  addr -= addr % sector_size();
+  if (_mem == nullptr || addr >= flash_size)
+    return false;
+  memset(_mem + addr, 0xff, sector_size());
+  store(addr, sector_size());
+  return true;
+}
+
+
+void QspiFlash::store(uint32_t addr, uint32_t len)
+{
+  if (_file == nullptr)
+    return;
+  fseek(_file, addr, SEEK_SET);
+  fwrite(_mem + addr, 1, len, _file);
+  fflush(_file);
+  hal::skip_host_time();
+}
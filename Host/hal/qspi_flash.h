@@ -0,0 +1,42 @@
+#pragma once
+
+// Host stand-in for the QSPI flash (libraries/PiMachine/qspi_flash.h). It
+// behaves like NOR flash (erase to ones, program clears bits) and is kept in
+// the file given to hal::set_flash_file(), so a checkpoint written by one run
+// of the simulator is there for the next. With no file it starts erased and
+// is forgotten at exit.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <checkpoint.h>
+
+class QspiFlash : public FlashDev {
+
+  public:
+
+    QspiFlash();
+    ~QspiFlash();
+
+    bool begin();
+
+    // bytes
+    uint32_t size() { return flash_size; }
+
+    virtual uint32_t sector_size() { return 4096; }
+
+    virtual bool read(uint32_t addr, void *buf, uint32_t len);
+
+    virtual bool program(uint32_t addr, const void *buf, uint32_t len);
+
+    virtual bool erase(uint32_t addr);
+
+  private:
+
+    static const uint32_t flash_size = 2 * 1024 * 1024;
+
+    uint8_t *_mem;
+    FILE *_file;
+
+    void store(uint32_t addr, uint32_t len);
+
+};
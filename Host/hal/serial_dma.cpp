@@ -0,0 +1,55 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "hal.h"
+#include "serial_dma.h"
+
+
+SerialDma::SerialDma(HardwareSerial& port) :
+  _port(port),
+  _byte_us(0),
+  _next_us(0),
+  _begun(false),
+  _busy(false)
+{
+}
+
+
+bool SerialDma::begin()
+{
+  // start, 8 data, stop
+  unsigned long baud = _port.baud() != 0 ? _port.baud() : 9600;
+  _byte_us = (10000000 + baud - 1) / baud;
+  if (!_begun)
+    hal::add_peripheral(this);
+  _begun = true;
+  kick();
+  return true;
+}
+
+
+uint64_t SerialDma::due_us()
+{
+  return _busy ? _next_us : UINT64_MAX;
+}
+
+
+void SerialDma::run()
+{
+  const uint8_t *p;
+  if (front(&p) > 0) {
+    _port.write(*p);
+    pop(1);
+  }
+  _busy = false;
+  kick();
+}
+
+
+void SerialDma::kick()
+{
+  const uint8_t *p;
+  if (!_begun || _busy || front(&p) == 0)
+    return;
+  _busy = true;
+  _next_us = hal::now_us() + _byte_us;
+}
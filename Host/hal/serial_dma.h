@@ -0,0 +1,42 @@
+#pragma once
+
+// Host stand-in for libraries/PiMachine/serial_dma.h. Instead of a DMA
+// channel, a hal::Peripheral moves the queued bytes to the port's device
+// one at a time, 10 bit times apart at the port's baud rate, while the
+// sketch carries on: the device (e.g. the printer emulator) sees each byte
+// when it would really have arrived.
+
+#include <Arduino.h>
+#include <tx_queue.h>
+#include "hal.h"
+
+class SerialDma : public TxQueue, public hal::Peripheral {
+
+  public:
+
+    // the printer's port (begin() happens first, for the baud rate)
+    SerialDma(HardwareSerial& port);
+
+    virtual bool begin();
+
+    // hal::Peripheral
+    virtual uint64_t due_us();
+    virtual void run();
+
+  protected:
+
+    virtual void kick();
+
+    // (a byte is only popped once it's been sent, so this is just whether
+    // one is under way)
+    virtual bool line_idle() const { return !_busy; }
+
+  private:
+
+    HardwareSerial& _port;
+    uint64_t _byte_us;
+    uint64_t _next_us;    // when the byte being sent is done
+    bool _begun;
+    bool _busy;
+
+};
@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Build a sketch for the host simulator.
+#
+#   ./host-build.sh 2022-11-17_PiMachine
+#
+# The result is build/2022-11-17_PiMachine; run it with --help.
+#
+# Like the Arduino builder, this puts prototypes for the sketch's functions
+# ahead of the sketch (the sketch can call things defined further down) and
+# compiles every .cpp in the sketch directory and in libraries/PiMachine.
+
+set -e
+
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g -std=gnu++17 -Wall"}
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <sketch>"
+    exit 1
+fi
+
+sketch=$(basename "$1")
+src=../Arduino/$sketch
+lib=../Arduino/libraries/PiMachine
+out=build/$sketch.d
+
+if [ ! -f "$src/$sketch.ino" ]; then
+    echo "$src/$sketch.ino not found"
+    exit 1
+fi
+
+mkdir -p "$out"
+
+# prototypes: a line that looks like a function header, followed by "{"
+{
+    echo "#include <Arduino.h>"
+    awk 'prev ~ /^[A-Za-z_][A-Za-z_0-9 \*&]* [\*&]?[A-Za-z_][A-Za-z_0-9]*\(.*\)$/ && $0 ~ /^\{/ {
+             print prev ";"
+         }
+         { prev = $0 }' "$src/$sketch.ino"
+    echo "#line 1 \"$src/$sketch.ino\""
+    cat "$src/$sketch.ino"
+} > "$out/$sketch.cpp"
+
+$CXX $CXXFLAGS -Ihal -I"$lib" -I"$src" -Isim \
+    "$out/$sketch.cpp" \
+    $(ls "$src"/*.cpp 2>/dev/null) \
+    "$lib"/*.cpp \
+    hal/*.cpp \
+    sim/*.cpp \
+    -o "build/$sketch"
+
+echo "build/$sketch"
@@ -0,0 +1,23 @@
+#!/bin/sh
+#
+# Build the bulk digit generator (Host/piprefill).
+#
+#   ./piprefill-build.sh
+#
+# The result is build/piprefill; run it with --help. It needs nothing from
+# the library or the simulator.
+
+set -e
+
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g -std=gnu++17 -Wall"}
+
+mkdir -p build
+
+$CXX $CXXFLAGS \
+    piprefill/piprefill.cpp piprefill/chudnovsky.cpp piprefill/bignum.cpp \
+    -o build/piprefill
+
+echo "build/piprefill"
@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "bignum.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Arena
+
+
+Arena::Arena(size_t bytes) :
+  _base(nullptr),
+  _size(bytes / sizeof(uint32_t)),
+  _top(0),
+  _high(0)
+{
+  _base = (uint32_t *)malloc(_size * sizeof(uint32_t));
+}
+
+
+Arena::~Arena()
+{
+  free(_base);
+}
+
+
+uint32_t *Arena::alloc(size_t n)
+{
+  if (n > _size - _top) {
+    fprintf(stderr, "arena full (%zu MB); try a bigger --arena-mb\n",
+            bytes() >> 20);
+    exit(1);
+  }
+  uint32_t *p = _base + _top;
+  _top += n;
+  if (_top > _high)
+    _high = _top;
+  return p;
+}
+
+
+namespace {
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Number-theoretic transform
+
+
+template <uint32_t P>
+struct Ntt {
+
+  static uint32_t mul(uint32_t a, uint32_t b) { return uint32_t(uint64_t(a) * b % P); }
+  static uint32_t add(uint32_t a, uint32_t b) { uint32_t s = a + b; return s >= P ? s - P : s; }
+  static uint32_t sub(uint32_t a, uint32_t b) { return a >= b ? a - b : a + P - b; }
+
+  static uint32_t pow(uint32_t a, uint64_t e)
+  {
+    uint32_t r = 1;
+    while (e > 0) {
+      if (e & 1)
+        r = mul(r, a);
+      a = mul(a, a);
+      e >>= 1;
+    }
+    return r;
+  }
+
+  // a * w mod P for a w known in advance, with ws = floor(w * 2^32 / P)
+  // (Shoup): two multiplies and no division. Any a < 2^32 will do, and the
+  // result is only reduced to [0, 2P).
+  static uint32_t mul_lazy(uint32_t a, uint32_t w, uint32_t ws)
+  {
+    uint32_t q = uint32_t((uint64_t(a) * ws) >> 32);
+    return a * w - q * P;
+  }
+
+  static uint32_t mul_pre(uint32_t a, uint32_t w, uint32_t ws)
+  {
+    uint32_t r = mul_lazy(a, w, ws);
+    return r >= P ? r - P : r;
+  }
+
+  // Twiddle factors for every stage up to the longest transform so far,
+  // kept between calls. The stage whose butterflies are h apart uses
+  // w[h + j] = root^j, j < h, root a primitive 2h'th root of unity (or its
+  // inverse); shorter transforms use the front of the same table, and the
+  // inner loops read it in order.
+  struct Roots {
+    std::vector<uint32_t> w;
+    std::vector<uint32_t> ws;
+  };
+
+  static const Roots& roots(size_t n, bool inverse)
+  {
+    static Roots tab[2];
+    Roots& t = tab[inverse];
+    size_t h = t.w.size();
+    if (h >= n)
+      return t;
+    if (h == 0)
+      h = 1;
+    t.w.resize(n);
+    t.ws.resize(n);
+    for ( ; h < n; h <<= 1) {
+      uint32_t root = pow(3, (P - 1) / (2 * h)); // 3 generates all three fields
+      if (inverse)
+        root = pow(root, P - 2);
+      uint32_t x = 1;
+      for (size_t j = 0; j < h; j++) {
+        t.w[h + j] = x;
+        t.ws[h + j] = uint32_t((uint64_t(x) << 32) / P);
+        x = mul(x, root);
+      }
+    }
+    return t;
+  }
+
+  // The butterflies (Harvey's) leave their results partly reduced, which
+  // saves a compare and subtract in each. The primes are below 2^30, so
+  // 4P still fits 32 bits.
+
+  // Forward: natural order in [0, P), bit-reversed out in [0, 2P)
+  // (decimation in frequency).
+  static void forward(uint32_t *a, size_t n)
+  {
+    const Roots& t = roots(n, false);
+    for (size_t half = n >> 1; half >= 1; half >>= 1) {
+      const uint32_t *w = &t.w[half];
+      const uint32_t *ws = &t.ws[half];
+      for (size_t i = 0; i < n; i += 2 * half) {
+        uint32_t *x = a + i;
+        uint32_t *y = a + i + half;
+        for (size_t j = 0; j < half; j++) {
+          uint32_t u = x[j];
+          uint32_t v = y[j];
+          uint32_t s = u + v;
+          x[j] = s >= 2 * P ? s - 2 * P : s;
+          y[j] = mul_lazy(u + 2 * P - v, w[j], ws[j]);
+        }
+      }
+    }
+  }
+
+  // Inverse: bit-reversed in [0, P), natural order out in [0, 4P)
+  // (decimation in time), not yet divided by n.
+  static void inverse(uint32_t *a, size_t n)
+  {
+    const Roots& t = roots(n, true);
+    for (size_t half = 1; half < n; half <<= 1) {
+      const uint32_t *w = &t.w[half];
+      const uint32_t *ws = &t.ws[half];
+      for (size_t i = 0; i < n; i += 2 * half) {
+        uint32_t *x = a + i;
+        uint32_t *y = a + i + half;
+        for (size_t j = 0; j < half; j++) {
+          uint32_t u = x[j] >= 2 * P ? x[j] - 2 * P : x[j];
+          uint32_t v = mul_lazy(y[j], w[j], ws[j]);
+          x[j] = u + v;
+          y[j] = u + 2 * P - v;
+        }
+      }
+    }
+  }
+
+  // a * b (cyclic, length n) mod P into r; fb is n limbs of scratch
+  // (unused when squaring)
+  static void convolve(const Num& a, const Num& b, size_t n,
+                       uint32_t *r, uint32_t *fb)
+  {
+    for (size_t i = 0; i < n; i++)
+      r[i] = i < a.n ? a.d[i] % P : 0;
+    forward(r, n);
+
+    if (a.d == b.d && a.n == b.n) {
+      for (size_t i = 0; i < n; i++)
+        r[i] = mul(r[i], r[i]);
+    } else {
+      for (size_t i = 0; i < n; i++)
+        fb[i] = i < b.n ? b.d[i] % P : 0;
+      forward(fb, n);
+      for (size_t i = 0; i < n; i++)
+        r[i] = mul(r[i], fb[i]);
+    }
+
+    inverse(r, n);
+    uint32_t inv_n = pow(uint32_t(n % P), P - 2);
+    uint32_t inv_ns = uint32_t((uint64_t(inv_n) << 32) / P);
+    for (size_t i = 0; i < n; i++)
+      r[i] = mul_pre(r[i], inv_n, inv_ns);
+  }
+
+};
+
+
+const uint32_t P1 = 998244353;  // 119 * 2^23 + 1
+const uint32_t P2 = 167772161;  //   5 * 2^25 + 1
+const uint32_t P3 = 469762049;  //   7 * 2^26 + 1
+
+// longest transform all three allow
+const size_t max_ntt = size_t(1) << 23;
+
+// Coefficients of the product are < (shorter length) * 10^18, which has to
+// be less than P1 * P2 * P3 (about 7.8e25) to come back out of the CRT.
+static_assert(double(P1) * P2 * P3 > 8e24, "primes too small for max_ntt");
+
+const uint32_t inv_p1_mod_p2 = Ntt<P2>::pow(P1 % P2, P2 - 2);
+const uint32_t inv_p1p2_mod_p3 = Ntt<P3>::pow(
+    uint32_t(uint64_t(P1) * P2 % P3), P3 - 2);
+
+
+// 2^64 = two64_hi * 10^9 + two64_lo
+const uint64_t two64_hi = 18446744073ull;
+const uint64_t two64_lo = 709551616ull;
+
+// x = q * 10^9 + r, for x up to about 2^88 (q must fit 64 bits)
+inline uint64_t divmod_base(unsigned __int128 x, uint32_t& r)
+{
+  uint64_t hi = uint64_t(x >> 64);
+  uint64_t lo = uint64_t(x);
+  uint64_t s = hi * two64_lo + lo % big::base;
+  r = uint32_t(s % big::base);
+  return hi * two64_hi + lo / big::base + s / big::base;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Magnitudes
+
+
+void trim(Num& a)
+{
+  while (a.n > 0 && a.d[a.n - 1] == 0)
+    a.n--;
+  if (a.n == 0)
+    a.neg = false;
+}
+
+
+int cmp_mag(const Num& a, const Num& b)
+{
+  if (a.n != b.n)
+    return a.n < b.n ? -1 : 1;
+  for (size_t i = a.n; i-- > 0; )
+    if (a.d[i] != b.d[i])
+      return a.d[i] < b.d[i] ? -1 : 1;
+  return 0;
+}
+
+
+Num add_mag(Arena& ar, const Num& a, const Num& b)
+{
+  const Num& l = a.n >= b.n ? a : b;
+  const Num& s = a.n >= b.n ? b : a;
+  Num r = { ar.alloc(l.n + 1), l.n + 1, false };
+  uint32_t carry = 0;
+  for (size_t i = 0; i < l.n; i++) {
+    uint32_t t = l.d[i] + (i < s.n ? s.d[i] : 0) + carry;
+    carry = t >= big::base;
+    r.d[i] = carry ? t - big::base : t;
+  }
+  r.d[l.n] = carry;
+  trim(r);
+  return r;
+}
+
+
+// |a| - |b|, |a| >= |b|
+Num sub_mag(Arena& ar, const Num& a, const Num& b)
+{
+  Num r = { ar.alloc(a.n), a.n, false };
+  uint32_t borrow = 0;
+  for (size_t i = 0; i < a.n; i++) {
+    uint32_t t = (i < b.n ? b.d[i] : 0) + borrow;
+    borrow = a.d[i] < t;
+    r.d[i] = borrow ? a.d[i] + big::base - t : a.d[i] - t;
+  }
+  trim(r);
+  return r;
+}
+
+
+// Column by column, so there's one division per result limb rather than
+// one per product: each column sums at most (shorter length) products
+// below 10^18, plus the carry in, which fits 128 bits with lots to spare.
+Num mul_schoolbook(Arena& ar, const Num& a, const Num& b)
+{
+  Num r = { ar.alloc(a.n + b.n), a.n + b.n, false };
+  uint64_t carry = 0;
+  for (size_t k = 0; k + 1 < r.n; k++) {
+    size_t i0 = k < b.n ? 0 : k - b.n + 1;
+    size_t i1 = std::min(k + 1, a.n);
+    unsigned __int128 col = carry;
+    for (size_t i = i0; i < i1; i++)
+      col += uint64_t(a.d[i]) * b.d[k - i];
+    carry = divmod_base(col, r.d[k]);
+  }
+  r.d[r.n - 1] = uint32_t(carry);
+  trim(r);
+  return r;
+}
+
+
+Num mul_ntt(Arena& ar, const Num& a, const Num& b)
+{
+  size_t len = a.n + b.n;
+  size_t n = 1;
+  while (n < len)
+    n <<= 1;
+  if (n > max_ntt) {
+    fprintf(stderr, "numbers too long to multiply (%zu limbs)\n", len);
+    exit(1);
+  }
+
+  Num r = { ar.alloc(len), len, false };
+
+  size_t m = ar.mark();
+  uint32_t *r1 = ar.alloc(n);
+  uint32_t *r2 = ar.alloc(n);
+  uint32_t *r3 = ar.alloc(n);
+  uint32_t *fb = ar.alloc(n);
+
+  Ntt<P1>::convolve(a, b, n, r1, fb);
+  Ntt<P2>::convolve(a, b, n, r2, fb);
+  Ntt<P3>::convolve(a, b, n, r3, fb);
+
+  // Garner: x = v1 + P1 * v2 + P1 * P2 * v3, then carry in base 10^9
+  uint64_t carry = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint32_t v1 = r1[i];
+    uint32_t v2 = Ntt<P2>::mul(Ntt<P2>::sub(r2[i], v1 % P2), inv_p1_mod_p2);
+    uint32_t t = Ntt<P3>::sub(r3[i], uint32_t((v1 + uint64_t(P1) * v2) % P3));
+    uint32_t v3 = Ntt<P3>::mul(t, inv_p1p2_mod_p3);
+    unsigned __int128 x = (unsigned __int128)(uint64_t(P1) * P2) * v3 +
+                          uint64_t(P1) * v2 + v1 + carry;
+    carry = divmod_base(x, r.d[i]);
+  }
+
+  ar.release(m);
+  trim(r);
+  return r;
+}
+
+
+} // namespace
+
+
+namespace big {
+
+
+Num from_u64(Arena& ar, uint64_t v)
+{
+  return from_u128(ar, v);
+}
+
+
+Num from_u128(Arena& ar, unsigned __int128 v)
+{
+  Num r = { ar.alloc(5), 5, false };
+  for (size_t i = 0; i < 5; i++) {
+    r.d[i] = uint32_t(v % base);
+    v /= base;
+  }
+  trim(r);
+  return r;
+}
+
+
+Num power(Arena& ar, size_t k)
+{
+  Num r = { ar.alloc(k + 1), k + 1, false };
+  memset(r.d, 0, k * sizeof(uint32_t));
+  r.d[k] = 1;
+  return r;
+}
+
+
+Num add(Arena& ar, const Num& a, const Num& b)
+{
+  Num r;
+  if (a.neg == b.neg) {
+    r = add_mag(ar, a, b);
+    r.neg = a.neg;
+  } else if (cmp_mag(a, b) >= 0) {
+    r = sub_mag(ar, a, b);
+    r.neg = a.neg;
+  } else {
+    r = sub_mag(ar, b, a);
+    r.neg = b.neg;
+  }
+  trim(r);
+  return r;
+}
+
+
+Num sub(Arena& ar, const Num& a, const Num& b)
+{
+  Num nb = b;
+  nb.neg = !b.neg;
+  return add(ar, a, nb);
+}
+
+
+Num mul(Arena& ar, const Num& a, const Num& b)
+{
+  Num r;
+  if (a.n == 0 || b.n == 0) {
+    r = { nullptr, 0, false };
+    return r;
+  }
+  if (std::min(a.n, b.n) < 48)
+    r = mul_schoolbook(ar, a, b);
+  else
+    r = mul_ntt(ar, a, b);
+  r.neg = (a.neg != b.neg) && r.n > 0;
+  return r;
+}
+
+
+Num mul_small(Arena& ar, const Num& a, uint32_t m)
+{
+  Num r = { ar.alloc(a.n + 2), a.n + 2, a.neg };
+  uint64_t carry = 0;
+  for (size_t i = 0; i < a.n; i++) {
+    uint64_t t = uint64_t(a.d[i]) * m + carry;
+    r.d[i] = uint32_t(t % base);
+    carry = t / base;
+  }
+  r.d[a.n] = uint32_t(carry % base);
+  r.d[a.n + 1] = uint32_t(carry / base);
+  trim(r);
+  return r;
+}
+
+
+Num div_small(Arena& ar, const Num& a, uint32_t m)
+{
+  Num r = { ar.alloc(a.n), a.n, a.neg };
+  uint64_t rem = 0;
+  for (size_t i = a.n; i-- > 0; ) {
+    uint64_t t = rem * base + a.d[i];
+    r.d[i] = uint32_t(t / m);
+    rem = t % m;
+  }
+  trim(r);
+  return r;
+}
+
+
+Num shift_up(Arena& ar, const Num& a, size_t k)
+{
+  if (a.n == 0)
+    return a;
+  Num r = { ar.alloc(a.n + k), a.n + k, a.neg };
+  memset(r.d, 0, k * sizeof(uint32_t));
+  memcpy(r.d + k, a.d, a.n * sizeof(uint32_t));
+  return r;
+}
+
+
+Num shift_down(const Num& a, size_t k)
+{
+  if (k >= a.n) {
+    Num z = { a.d, 0, false };
+    return z;
+  }
+  Num r = { a.d + k, a.n - k, a.neg };
+  return r;
+}
+
+
+void keep(Arena& ar, size_t mark, Num *v[], int count)
+{
+  // lowest first, so nothing is overwritten before it's moved
+  std::sort(v, v + count, [](const Num *x, const Num *y) { return x->d < y->d; });
+
+  uint32_t *dst = ar.at(mark);
+  for (int i = 0; i < count; i++) {
+    Num& x = *v[i];
+    if (x.n > 0 && x.d >= ar.at(mark)) {
+      memmove(dst, x.d, x.n * sizeof(uint32_t));
+      x.d = dst;
+      dst += x.n;
+    }
+  }
+  ar.release(dst - ar.at(0));
+}
+
+
+} // namespace big
@@ -0,0 +1,81 @@
+#pragma once
+
+// Just enough arbitrary-precision integer arithmetic for piprefill.
+//
+// Numbers are base 10^9 limbs, least significant first, so the result
+// prints as decimal without converting. Every limb comes from one Arena,
+// sized up front: running out says so and stops rather than swapping the
+// machine to death. (The transform's twiddle tables are the exception;
+// they're kept between multiplies, and grow to twice the longest product.)
+//
+// Multiplication is schoolbook for short operands and a number-theoretic
+// transform (three 30-bit primes, put back together with the Chinese
+// remainder theorem) for long ones.
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Arena {
+
+  public:
+
+    explicit Arena(size_t bytes);
+    ~Arena();
+
+    bool ok() const { return _base != nullptr; }
+
+    // n limbs, uninitialized; exits if there isn't room
+    uint32_t *alloc(size_t n);
+
+    // everything allocated after mark() is freed by release()
+    size_t mark() const { return _top; }
+    void release(size_t mark) { _top = mark; }
+    uint32_t *at(size_t mark) const { return _base + mark; }
+
+    size_t bytes() const { return _size * sizeof(uint32_t); }
+    size_t high_water_bytes() const { return _high * sizeof(uint32_t); }
+
+  private:
+
+    uint32_t *_base;
+    size_t _size;
+    size_t _top;
+    size_t _high;
+
+};
+
+
+struct Num {
+  uint32_t *d;    // limbs, least significant first
+  size_t n;       // d[n - 1] != 0, or n == 0 for zero
+  bool neg;
+};
+
+
+namespace big {
+
+const uint32_t base = 1000000000;
+
+Num from_u64(Arena& ar, uint64_t v);
+Num from_u128(Arena& ar, unsigned __int128 v);
+
+// base^k
+Num power(Arena& ar, size_t k);
+
+Num add(Arena& ar, const Num& a, const Num& b);
+Num sub(Arena& ar, const Num& a, const Num& b);
+Num mul(Arena& ar, const Num& a, const Num& b);
+Num mul_small(Arena& ar, const Num& a, uint32_t m);
+Num div_small(Arena& ar, const Num& a, uint32_t m);  // toward zero
+
+// a * base^k
+Num shift_up(Arena& ar, const Num& a, size_t k);
+
+// a / base^k, toward zero; shares a's limbs
+Num shift_down(const Num& a, size_t k);
+
+// Move the numbers in v[] (which are everything worth keeping that was
+// allocated since mark) down to mark, and free the rest.
+void keep(Arena& ar, size_t mark, Num *v[], int count);
+
+} // namespace big
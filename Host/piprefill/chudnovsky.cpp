@@ -0,0 +1,180 @@
+#include <math.h>
+#include "chudnovsky.h"
+
+//          426880 sqrt(10005) Q(0, N)
+//   pi = ---------------------------
+//                  T(0, N)
+//
+// where, for terms [a, b) of the series,
+//
+//   one term (b = a + 1):
+//     P = (6a - 5)(2a - 1)(6a - 1)       (1 for a = 0)
+//     Q = a^3 640320^3 / 24              (1 for a = 0)
+//     T = (-1)^a P (13591409 + 545140134 a)
+//   and splitting [a, b) at m:
+//     P = P(a, m) P(m, b)
+//     Q = Q(a, m) Q(m, b)
+//     T = T(a, m) Q(m, b) + P(a, m) T(m, b)
+//
+// Each term adds about 14.18 digits.
+
+using namespace big;
+
+static const double digits_per_term = 14.181647462725477;
+
+// limbs past the ones asked for, to absorb rounding
+static const size_t guard_limbs = 2;
+
+
+// Series terms [a, b) into P, Q and T, left at the arena mark they started
+// from. The rightmost branch doesn't need P.
+static void split(Arena& ar, long a, long b, Num& P, Num& Q, Num& T, bool need_p)
+{
+  size_t m0 = ar.mark();
+
+  if (b - a == 1) {
+    if (a == 0) {
+      P = from_u64(ar, 1);
+      Q = from_u64(ar, 1);
+      T = from_u64(ar, 13591409);
+    } else {
+      uint64_t ua = uint64_t(a);
+      Num p = mul_small(ar, from_u64(ar, (6 * ua - 5) * (2 * ua - 1)), uint32_t(6 * ua - 1));
+      Num q = mul_small(ar, mul_small(ar, from_u64(ar, ua * ua), uint32_t(ua)), 640320);
+      q = mul_small(ar, mul_small(ar, q, 640320), 26680); // 640320^3 / 24
+      Num t = mul(ar, p, from_u64(ar, 13591409 + 545140134 * ua));
+      t.neg = (a & 1) != 0;
+      P = p;
+      Q = q;
+      T = t;
+    }
+    Num *v[] = { &P, &Q, &T };
+    keep(ar, m0, v, 3);
+    return;
+  }
+
+  long m = (a + b) / 2;
+  Num P1, Q1, T1, P2, Q2, T2;
+  split(ar, a, m, P1, Q1, T1, true);
+  split(ar, m, b, P2, Q2, T2, need_p);
+
+  T = add(ar, mul(ar, T1, Q2), mul(ar, P1, T2));
+  Q = mul(ar, Q1, Q2);
+  if (need_p)
+    P = mul(ar, P1, P2);
+  else
+    P = from_u64(ar, 0);
+
+  Num *v[] = { &P, &Q, &T };
+  keep(ar, m0, v, 3);
+}
+
+
+// Y ~ base^(p + b.n) / b, good to about p limbs
+static Num reciprocal(Arena& ar, const Num& b, size_t p)
+{
+  size_t m0 = ar.mark();
+
+  // only the top p + 2 limbs matter
+  Num bt = b.n > p + 2 ? shift_down(b, b.n - (p + 2)) : b;
+  size_t n = bt.n;
+
+  Num y;
+  if (p <= 2) {
+    // bt / base^(n-1) is in [1, base); y = base^(p+1) / that
+    long double f = bt.d[n - 1];
+    if (n > 1)
+      f += bt.d[n - 2] / 1e9L;
+    if (n > 2)
+      f += bt.d[n - 3] / 1e18L;
+    y = from_u128(ar, (unsigned __int128)(powl(1e9L, p + 1) / f));
+  } else {
+    // Newton: y = y0 + y0 (base^(p+n) - bt y0) / base^(p+n)
+    size_t h = p / 2 + 1;
+    Num y0 = shift_up(ar, reciprocal(ar, bt, h), p - h);
+    Num e = sub(ar, power(ar, p + n), mul(ar, bt, y0));
+    y = add(ar, y0, shift_down(mul(ar, y0, e), p + n));
+  }
+
+  Num *v[] = { &y };
+  keep(ar, m0, v, 1);
+  return y;
+}
+
+
+// Y ~ base^p / sqrt(c)
+static Num inv_sqrt(Arena& ar, uint32_t c, size_t p)
+{
+  size_t m0 = ar.mark();
+
+  Num y;
+  if (p <= 2) {
+    y = from_u128(ar, (unsigned __int128)(powl(1e9L, p) / sqrtl(c)));
+  } else {
+    // Newton: y = y0 + y0 (base^2p - c y0^2) / (2 base^2p)
+    size_t h = p / 2 + 1;
+    Num y0 = shift_up(ar, inv_sqrt(ar, c, h), p - h);
+    Num e = sub(ar, power(ar, 2 * p), mul_small(ar, mul(ar, y0, y0), c));
+    y = add(ar, y0, div_small(ar, shift_down(mul(ar, y0, e), 2 * p), 2));
+  }
+
+  Num *v[] = { &y };
+  keep(ar, m0, v, 1);
+  return y;
+}
+
+
+bool pi_digits(Arena& ar, long digits, std::string& out)
+{
+  size_t m0 = ar.mark();
+
+  size_t limbs = size_t(digits + 8) / 9 + guard_limbs;
+  long terms = long(double(digits) / digits_per_term) + 2;
+
+  Num P, Q, T;
+  split(ar, 0, terms, P, Q, T, false);
+
+  // Only Q / T matters; drop the same number of low limbs from both.
+  size_t drop = std::min(Q.n, T.n);
+  drop = drop > limbs + 2 ? drop - (limbs + 2) : 0;
+  Q = shift_down(Q, drop);
+  T = shift_down(T, drop);
+  {
+    Num *v[] = { &Q, &T };
+    keep(ar, m0, v, 2);
+  }
+
+  // x = 426880 sqrt(10005) base^limbs * Q * (base^(limbs + T.n) / T)
+  //       / base^(limbs + T.n)
+  //   ~ pi * base^limbs
+  Num s = mul_small(ar, mul_small(ar, inv_sqrt(ar, 10005, limbs), 10005), 426880);
+  Num x = mul(ar, s, Q);
+  x = mul(ar, x, reciprocal(ar, T, limbs));
+  x = shift_down(x, limbs + T.n);
+
+  // "3" then 9 digits per limb
+  out.clear();
+  out.reserve(x.n * 9);
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u", x.d[x.n - 1]);
+  out += buf;
+  for (size_t i = x.n - 1; i-- > 0; ) {
+    snprintf(buf, sizeof(buf), "%09u", x.d[i]);
+    out += buf;
+  }
+
+  ar.release(m0);
+
+  // The guard digits soak up the error (a few units in the last limb) as
+  // long as it can't carry into the digits wanted.
+  bool ok = true;
+  if (long(out.size()) >= digits + 1 + 12) {
+    std::string g = out.substr(digits + 1, 12);
+    ok = g.find_first_not_of('0') != std::string::npos &&
+         g.find_first_not_of('9') != std::string::npos;
+  }
+
+  out.resize(digits + 1);
+  out.erase(0, 1); // the 3
+  return ok;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include "bignum.h"
+
+// The first 'digits' digits of pi after the decimal point, by the
+// Chudnovsky series with binary splitting. Everything comes from 'ar'.
+//
+// Returns false if the last few digits can't be trusted (the digits
+// after them are a long run of 0s or 9s, so the rounding error could
+// carry into them); ask for a few more.
+bool pi_digits(Arena& ar, long digits, std::string& out);
@@ -0,0 +1,163 @@
+// piprefill: the first however-many digits of pi, all at once.
+//
+//   build/piprefill --digits 1000000 --store pi.txt
+//
+// DigitsOfPi is for one digit, far out, in almost no memory. For all the
+// digits up to some point, a series that gets them all at once is far
+// faster; this is the Chudnovsky series, by binary splitting, with its own
+// bignums (bignum.h). The results seed what wants a run of known digits:
+//
+//   --store FILE       the digit store piserve reads (it computes with
+//                      DigitsOfPi past the end of it)
+//   --tiny FILE        the Tiny Pi Machine's pi.cpp (--tiny-len digits)
+//   --reference FILE   pidec_test's pi16k.cpp (--reference-len digits)
+//
+// With the default lengths, the last two come out the same as the ones in
+// the repository.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "bignum.h"
+#include "chudnovsky.h"
+
+
+static bool write_file(const char *path, const std::string& s)
+{
+  FILE *f = fopen(path, "w");
+  if (f == nullptr) {
+    perror(path);
+    return false;
+  }
+  bool ok = fwrite(s.data(), 1, s.size(), f) == s.size();
+  ok = fclose(f) == 0 && ok;
+  if (!ok)
+    perror(path);
+  return ok;
+}
+
+
+// digits, 'per_line' at a time, as lines of a C string continued with '\'
+static std::string c_lines(const std::string& d, size_t per_line)
+{
+  std::string s;
+  for (size_t i = 0; i < d.size(); i += per_line)
+    s += d.substr(i, per_line) + "\\\n";
+  return s;
+}
+
+
+// the same, with the string ending on the last line of digits
+static std::string end_lines(const std::string& lines)
+{
+  return lines.substr(0, lines.size() > 2 ? lines.size() - 2 : 0);
+}
+
+
+static void usage()
+{
+  printf("usage: piprefill --digits N [options]\n");
+  printf("  --digits N         digits after the decimal point (default 1000000)\n");
+  printf("  --store FILE       write them as a digit store (\"3.14159...\")\n");
+  printf("  --tiny FILE        write the Tiny's pi.cpp\n");
+  printf("  --tiny-len N       digits in it, counting the 3 (default 10000)\n");
+  printf("  --reference FILE   write pidec_test's pi16k.cpp\n");
+  printf("  --reference-len N  digits in it, counting the 3 (default 16384)\n");
+  printf("  --arena-mb MB      memory to compute in (default: enough for N)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  long digits = 1000000;
+  const char *store_path = nullptr;
+  const char *tiny_path = nullptr;
+  long tiny_len = 10000;
+  const char *ref_path = nullptr;
+  long ref_len = 16384;
+  long arena_mb = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--digits") == 0 && val) {
+      digits = atol(val); i++;
+    } else if (strcmp(arg, "--store") == 0 && val) {
+      store_path = val; i++;
+    } else if (strcmp(arg, "--tiny") == 0 && val) {
+      tiny_path = val; i++;
+    } else if (strcmp(arg, "--tiny-len") == 0 && val) {
+      tiny_len = atol(val); i++;
+    } else if (strcmp(arg, "--reference") == 0 && val) {
+      ref_path = val; i++;
+    } else if (strcmp(arg, "--reference-len") == 0 && val) {
+      ref_len = atol(val); i++;
+    } else if (strcmp(arg, "--arena-mb") == 0 && val) {
+      arena_mb = atol(val); i++;
+    } else {
+      usage();
+      return strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  // the tables count the 3
+  long want = digits;
+  if (tiny_path != nullptr && tiny_len - 1 > want)
+    want = tiny_len - 1;
+  if (ref_path != nullptr && ref_len - 1 > want)
+    want = ref_len - 1;
+  if (want < 1) {
+    usage();
+    return 1;
+  }
+
+  // The peak, with the transform buffers, grows a little faster than the
+  // digits: 15 MB for a million, 136 MB for ten million. This leaves room
+  // (and malloc only gets pages as they're touched, so it costs nothing).
+  if (arena_mb == 0)
+    arena_mb = want * 20 / (1 << 20) + 16;
+  Arena arena(size_t(arena_mb) << 20);
+  if (!arena.ok()) {
+    fprintf(stderr, "can't get %ld MB\n", arena_mb);
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  // if the end is too close to call, get a few more and look again
+  std::string d;
+  long extra = 0;
+  while (!pi_digits(arena, want + extra, d))
+    extra += 100;
+  d.resize(want);
+
+  double s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  printf("%ld digits in %.2f s (%.0f digits/s), arena %zu of %zu MB\n", want,
+         s, s > 0. ? double(want) / s : 0., arena.high_water_bytes() >> 20,
+         arena.bytes() >> 20);
+  printf("last digits: ...%s\n", d.substr(d.size() > 20 ? d.size() - 20 : 0).c_str());
+
+  if (store_path != nullptr &&
+      !write_file(store_path, "3." + d.substr(0, digits) + "\n"))
+    return 1;
+
+  if (tiny_path != nullptr &&
+      !write_file(tiny_path,
+                  "#include <Arduino.h>\n#include \"pi.h\"\n\n"
+                  "const int pi_len = " + std::to_string(tiny_len) + ";\n\n"
+                  "const char pi[] PROGMEM = \"\\\n" +
+                  c_lines("3" + d.substr(0, tiny_len - 1), 50) + "\";\n"))
+    return 1;
+
+  if (ref_path != nullptr &&
+      !write_file(ref_path,
+                  "#include \"pi16k.h\"\n\nconst char *pi16k = \"\\\n" +
+                  end_lines(c_lines("3" + d.substr(0, ref_len - 1), 64)) +
+                  "\";\n"))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Build the digit query server, its load generator, and the search index
+# benchmark (Host/piserve).
+#
+#   ./piserve-build.sh
+#
+# The results are build/piserve, build/piload, and build/pifind; run them
+# with --help.
+# These aren't sketches: piserve uses the library's DigitsOfPi, but not
+# the simulator.
+
+set -e
+
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g -std=gnu++17 -Wall -pthread"}
+
+lib=../Arduino/libraries/PiMachine
+
+mkdir -p build
+
+# (the library has a sched.h; system headers come first)
+$CXX $CXXFLAGS -Ihal -idirafter "$lib" \
+    piserve/piserve.cpp piserve/digit_service.cpp piserve/digit_store.cpp \
+    piserve/search_index.cpp \
+    "$lib"/pidec.cpp "$lib"/pidec_tune.cpp \
+    -o build/piserve
+
+$CXX $CXXFLAGS piserve/piload.cpp -o build/piload
+
+$CXX $CXXFLAGS piserve/pifind.cpp piserve/digit_store.cpp \
+    piserve/search_index.cpp -o build/pifind
+
+echo "build/piserve build/piload build/pifind"
@@ -0,0 +1,185 @@
+#include <Arduino.h>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <pidec.h>
+#include "digit_service.h"
+
+// DigitsOfPi needs at least 50 digits to work with (see the sketch), so the
+// first ones are looked up.
+static const char *pi50 =
+    "3141592653589793238462643383279502884197169399375105820974944";
+static const long pi50_len = 61;
+
+// How far off DigitsOfPi might be. Measured worst is about 1e-13 at 16000
+// digits, growing slowly with n; this leaves a lot of room.
+static const double digits_error = 1e-9;
+
+// Digits taken from each DigitsOfPi call, when the value isn't too close
+// to a digit boundary to trust that many.
+static const int digits_per_call = 6;
+
+
+static uint64_t now_us()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+DigitService::DigitService(const DigitStore& store, size_t cache_blocks,
+                           int shards) :
+  _store(store),
+  _shard_blocks(cache_blocks / shards > 0 ? cache_blocks / shards : 1),
+  _shards(shards),
+  _requests(0),
+  _digits(0),
+  _store_digits(0),
+  _cache_hits(0),
+  _computed(0),
+  _coalesced(0),
+  _evicted(0),
+  _compute_us(0)
+{
+}
+
+
+void DigitService::get(long a, long b, char *out)
+{
+  _requests++;
+  _digits += b - a;
+
+  // as much as the store has
+  long num = a;
+  while (num < b && num < _store.end()) {
+    char c = _store.get(num);
+    if (c == 0)
+      break; // hole in the file; compute from here
+    *out++ = c;
+    num++;
+  }
+  _store_digits += num - a;
+
+  while (num < b) {
+    long blk = num / block_len;
+    Block d = block(blk);
+    long off = num - blk * block_len;
+    long n = block_len - off;
+    if (n > b - num)
+      n = b - num;
+    memcpy(out, d.data() + off, n);
+    out += n;
+    num += n;
+  }
+}
+
+
+DigitService::Stats DigitService::stats() const
+{
+  Stats s;
+  s.requests = _requests;
+  s.digits = _digits;
+  s.store_digits = _store_digits;
+  s.cache_hits = _cache_hits;
+  s.computed = _computed;
+  s.coalesced = _coalesced;
+  s.evicted = _evicted;
+  s.compute_us = _compute_us;
+  s.p50_us = latency.percentile(0.50);
+  s.p99_us = latency.percentile(0.99);
+  return s;
+}
+
+
+// Block blk from the cache, from whoever is computing it, or computed here.
+DigitService::Block DigitService::block(long blk)
+{
+  Shard& sh = _shards[blk % _shards.size()];
+
+  std::unique_lock<std::mutex> lock(sh.lock);
+
+  auto hit = sh.index.find(blk);
+  if (hit != sh.index.end()) {
+    sh.lru.splice(sh.lru.begin(), sh.lru, hit->second);
+    _cache_hits++;
+    return hit->second->second;
+  }
+
+  auto p = sh.pending.find(blk);
+  if (p != sh.pending.end()) {
+    std::shared_future<Block> f = p->second;
+    lock.unlock();
+    _coalesced++;
+    return f.get();
+  }
+
+  std::promise<Block> promise;
+  sh.pending[blk] = promise.get_future().share();
+  lock.unlock();
+
+  uint64_t start_us = now_us();
+  Block d = compute(blk);
+  _compute_us += now_us() - start_us;
+  _computed++;
+
+  lock.lock();
+  sh.lru.emplace_front(blk, d);
+  sh.index[blk] = sh.lru.begin();
+  if (sh.lru.size() > _shard_blocks) {
+    sh.index.erase(sh.lru.back().first);
+    sh.lru.pop_back();
+    _evicted++;
+  }
+  sh.pending.erase(blk);
+  lock.unlock();
+
+  promise.set_value(d);
+  return d;
+}
+
+
+DigitService::Block DigitService::compute(long blk)
+{
+  Block d;
+  long first = blk * block_len;
+
+  int i = 0;
+  while (i < block_len) {
+
+    long num = first + i;
+
+    if (num < pi50_len) {
+      d[i++] = pi50[num];
+      continue;
+    }
+
+    if (num < _store.end() && _store.get(num) != 0) {
+      d[i++] = _store.get(num);
+      continue;
+    }
+
+    // DigitsOfPi(n) is the fraction starting at digit n + 1. Take as many
+    // digits as the error allows: after k of them, what's left has to be
+    // farther than the error (times 10^k) from rolling over either way.
+    double x = DigitsOfPi(num - 1);
+    int want = block_len - i < digits_per_call ? block_len - i : digits_per_call;
+    for (int k = want; k >= 1; k--) {
+      double y = x * pow(10., k);
+      double margin = digits_error * pow(10., k);
+      double rest = y - floor(y);
+      if (k == 1 || (rest > margin && rest < 1. - margin)) {
+        // y < 10^k; peel off the digits most significant first
+        long v = long(floor(y));
+        for (int j = k - 1; j >= 0; j--) {
+          d[i + j] = char('0' + v % 10);
+          v /= 10;
+        }
+        i += k;
+        break;
+      }
+    }
+
+  }
+
+  return d;
+}
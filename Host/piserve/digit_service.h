@@ -0,0 +1,81 @@
+#pragma once
+
+// Answers "digits [a, b)" from the DigitStore where it can, and otherwise
+// computes them with DigitsOfPi, a block of 64 at a time. Computed blocks
+// go in an LRU cache split into shards (each with its own lock, so
+// requests on different threads rarely wait for each other). A block that
+// is already being computed for one request is waited for by any other
+// that wants it, not computed again.
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "digit_store.h"
+#include "latency.h"
+
+class DigitService {
+
+  public:
+
+    static const int block_len = 64;
+
+    // cache_blocks is the total over all shards
+    DigitService(const DigitStore& store, size_t cache_blocks, int shards);
+
+    // Digits [a, b) into out (b - a chars, no terminator). 0 <= a <= b.
+    void get(long a, long b, char *out);
+
+    // counts since start
+    struct Stats {
+      uint64_t requests;
+      uint64_t digits;
+      uint64_t store_digits;    // came straight from the store
+      uint64_t cache_hits;      // blocks found in the cache
+      uint64_t computed;        // blocks computed
+      uint64_t coalesced;       // blocks another request was computing
+      uint64_t evicted;
+      uint64_t compute_us;      // time spent computing
+      uint32_t p50_us;          // request latency
+      uint32_t p99_us;
+    };
+
+    Stats stats() const;
+
+    // How long requests took; the server adds to this (it sees the whole
+    // request, including reading and writing the socket).
+    LatencyHistogram latency;
+
+  private:
+
+    typedef std::array<char, block_len> Block;
+
+    struct Shard {
+      std::mutex lock;
+      // most recently used first
+      std::list<std::pair<long, Block>> lru;
+      std::unordered_map<long, std::list<std::pair<long, Block>>::iterator> index;
+      // blocks being computed right now
+      std::unordered_map<long, std::shared_future<Block>> pending;
+    };
+
+    const DigitStore& _store;
+    size_t _shard_blocks;
+    std::vector<Shard> _shards;
+
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _digits;
+    std::atomic<uint64_t> _store_digits;
+    std::atomic<uint64_t> _cache_hits;
+    std::atomic<uint64_t> _computed;
+    std::atomic<uint64_t> _coalesced;
+    std::atomic<uint64_t> _evicted;
+    std::atomic<uint64_t> _compute_us;
+
+    Block block(long blk);
+    Block compute(long blk);
+};
@@ -0,0 +1,98 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "digit_store.h"
+
+
+DigitStore::DigitStore() :
+  _fd(-1),
+  _map(nullptr),
+  _map_len(0),
+  _digits(nullptr),
+  _end(1)
+{
+}
+
+
+DigitStore::~DigitStore()
+{
+  if (_map != nullptr)
+    munmap((void *)_map, _map_len);
+  if (_fd >= 0)
+    close(_fd);
+}
+
+
+bool DigitStore::open(const char *path)
+{
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    perror(path);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    fprintf(stderr, "%s: empty or unreadable\n", path);
+    close(fd);
+    return false;
+  }
+
+  _map_len = size_t(st.st_size) > map_reserve ? size_t(st.st_size) : map_reserve;
+  void *p = mmap(nullptr, _map_len, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    perror(path);
+    close(fd);
+    return false;
+  }
+
+  _fd = fd;
+  _map = (const char *)p;
+
+  // mostly read in order, a block at a time
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+  _digits = _map;
+  if (st.st_size >= 2 && _digits[0] == '3' && _digits[1] == '.')
+    _digits += 2;
+
+  _end = digits_end(st.st_size);
+  return true;
+}
+
+
+bool DigitStore::refresh()
+{
+  struct stat st;
+  if (_fd < 0 || fstat(_fd, &st) != 0)
+    return false;
+  if (size_t(st.st_size) > _map_len)
+    return false; // past what's mapped; reopen to see it
+  long end = digits_end(st.st_size);
+  if (end <= _end)
+    return false;
+  _end.store(end, std::memory_order_release);
+  return true;
+}
+
+
+// end() for a file this long (whitespace at the end doesn't count)
+long DigitStore::digits_end(size_t file_len) const
+{
+  size_t len = file_len - (_digits - _map);
+  while (len > 0 && isspace((unsigned char)_digits[len - 1]))
+    len--;
+  return 1 + long(len);
+}
+
+
+char DigitStore::get(long num) const
+{
+  if (num == 0)
+    return '3';
+  char c = _digits[num - 1];
+  return ('0' <= c && c <= '9') ? c : 0;
+}
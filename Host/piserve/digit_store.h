@@ -0,0 +1,53 @@
+#pragma once
+
+// Digits of pi already worked out, in a file: ASCII digits after the
+// decimal point ("14159..."), optionally with the "3." in front, and
+// whitespace at the end is fine. The file is mapped read-only, so it can
+// be as big as the disk and costs nothing until something looks at it.
+//
+// Numbering is the printout's: the '3' is 0 and the first '1' is 1.
+//
+// More digits can be appended to the file while it's open (with nothing
+// in between: a newline left at the old end would be a hole); refresh()
+// picks them up.
+
+#include <atomic>
+#include <stddef.h>
+
+class DigitStore {
+
+  public:
+
+    DigitStore();
+    ~DigitStore();
+
+    bool open(const char *path);
+
+    // digits [0, end()) are in the store (end() is 1 if there's no file)
+    long end() const { return _end.load(std::memory_order_acquire); }
+
+    // the digit at num (< end()), or 0 if the file has something else there
+    char get(long num) const;
+
+    // what the file has at num (1 <= num < end()), for reading a run of
+    // digits at once
+    const char *at(long num) const { return _digits + (num - 1); }
+
+    // Has the file grown? Safe while other threads read.
+    bool refresh();
+
+  private:
+
+    // Address space mapped, so the file can grow into it without moving
+    // (past the end of the file it's only address space).
+    static const size_t map_reserve = size_t(1) << 36;
+
+    int _fd;
+    const char *_map;
+    size_t _map_len;
+    const char *_digits;  // num 1
+    std::atomic<long> _end;
+
+    long digits_end(size_t file_len) const;
+
+};
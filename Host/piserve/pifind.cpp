@@ -0,0 +1,151 @@
+// pifind: where strings of digits first turn up in a digit store, and how
+// fast the search index (search_index.h) is built and answers.
+//
+//   build/pifind --store pi.txt 0714 19690720
+//   build/pifind --store pi.txt --step 100000 --queries 100000 --check 200
+//
+// It builds the index --step digits at a time, as if the store were
+// growing, and prints the build rate (and the slowest step, which is about
+// what piserve pays when the store gains that many). Then it looks up the
+// strings given, if any, and --queries random ones of each length from 1 to
+// 10, and prints how long those took. --check compares that many of the
+// random ones with a plain search of the store.
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "digit_store.h"
+#include "latency.h"
+#include "search_index.h"
+
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void usage()
+{
+  printf("usage: pifind --store FILE [options] [DIGITS...]\n");
+  printf("  --threads N        threads to build with (default: all)\n");
+  printf("  --step N           digits to index at a time (default: all at once)\n");
+  printf("  --queries N        random lookups of each length (default 0)\n");
+  printf("  --check N          of those, check N against a plain search (default 0)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *store_path = nullptr;
+  int threads = int(std::thread::hardware_concurrency());
+  long step = 0;
+  long queries = 0;
+  long check = 0;
+  std::vector<const char *> find;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--store") == 0 && val) {
+      store_path = val; i++;
+    } else if (strcmp(arg, "--threads") == 0 && val) {
+      threads = atoi(val); i++;
+    } else if (strcmp(arg, "--step") == 0 && val) {
+      step = atol(val); i++;
+    } else if (strcmp(arg, "--queries") == 0 && val) {
+      queries = atol(val); i++;
+    } else if (strcmp(arg, "--check") == 0 && val) {
+      check = atol(val); i++;
+    } else if (arg[0] != '-' && strspn(arg, "0123456789") == strlen(arg)) {
+      find.push_back(arg);
+    } else {
+      usage();
+      return strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if (store_path == nullptr || threads < 1) {
+    usage();
+    return 1;
+  }
+
+  DigitStore store;
+  if (!store.open(store_path))
+    return 1;
+
+  SearchIndex index(store, threads);
+
+  auto start = std::chrono::steady_clock::now();
+  double max_s = 0.;
+  long steps = 0;
+  for (long to = step > 0 ? step : store.end(); ; to += step) {
+    auto t = std::chrono::steady_clock::now();
+    index.extend(to);
+    double ts = seconds_since(t);
+    if (ts > max_s)
+      max_s = ts;
+    steps++;
+    if (step <= 0 || to >= store.end())
+      break;
+  }
+  double s = seconds_since(start);
+  long digits = index.end() - 1;
+  printf("%ld digits indexed in %.3f s (%.1f M digits/s, %d thread%s), %zu MB\n",
+         digits, s, s > 0. ? double(digits) / s / 1e6 : 0., threads,
+         threads == 1 ? "" : "s", index.bytes() >> 20);
+  if (step > 0)
+    printf("%ld steps of %ld: %.1f ms each on average, %.1f ms at most\n",
+           steps, step, s * 1e3 / double(steps), max_s * 1e3);
+
+  for (const char *f : find) {
+    long num = index.find(f, int(strlen(f)));
+    if (num < 0)
+      printf("%s: not in the first %ld digits\n", f, digits);
+    else
+      printf("%s: at %ld\n", f, num);
+  }
+
+  if (queries <= 0)
+    return 0;
+
+  std::string_view all(store.at(1), size_t(digits));
+  std::mt19937 rng(1);
+  long wrong = 0;
+  printf("len  found     p50     p99  (ns per lookup)\n");
+  for (int len = 1; len <= 10; len++) {
+    LatencyHistogram ns;
+    long found = 0;
+    char s[16];
+    for (long q = 0; q < queries; q++) {
+      for (int i = 0; i < len; i++)
+        s[i] = char('0' + rng() % 10);
+      auto t = std::chrono::steady_clock::now();
+      long num = index.find(s, len);
+      ns.add(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - t).count()));
+      if (num >= 0)
+        found++;
+      if (q < check) {
+        size_t at = all.find(std::string_view(s, len));
+        long want = at == std::string_view::npos ? -1 : long(at) + 1;
+        if (num != want) {
+          printf("  %.*s: %ld, should be %ld\n", len, s, num, want);
+          wrong++;
+        }
+      }
+    }
+    printf("%3d %5.1f%% %7u %7u\n", len, 100. * double(found) / double(queries),
+           ns.percentile(0.50), ns.percentile(0.99));
+  }
+  if (check > 0)
+    printf("checked %ld, %ld wrong\n", check * 10, wrong);
+
+  return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+// piload: keep piserve busy and see how it holds up.
+//
+//   build/piload --socket /tmp/piserve.sock --clients 8 --requests 2000
+//
+// Each client connects, then asks for --len digits at a time, one request
+// after another. Where they start is skewed toward the beginning (the
+// cube of a uniform number, times --max), so some are asked for again and
+// again and the rest are spread out, like a dashboard plus some browsing.
+// At the end it prints what the clients saw and what the server says.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const char *socket_path = nullptr;
+static int port = 0;
+
+
+static int connect_server()
+{
+  int fd;
+  if (socket_path != nullptr) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+      close(fd);
+      return -1;
+    }
+  } else {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+
+// send one request line, return the answer line (without the newline)
+static bool request(int fd, const std::string& req, std::string& ans)
+{
+  std::string line = req + "\n";
+  if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != ssize_t(line.size()))
+    return false;
+
+  ans.clear();
+  char buf[4096];
+  while (ans.empty() || ans.back() != '\n') {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0)
+      return false;
+    ans.append(buf, n);
+  }
+  ans.pop_back();
+  return true;
+}
+
+
+struct Client {
+  std::vector<uint32_t> us;   // latency of each request
+  long errors = 0;
+};
+
+
+static void run_client(Client& c, unsigned seed, int requests, long len,
+                       long max)
+{
+  int fd = connect_server();
+  if (fd < 0) {
+    c.errors = requests;
+    return;
+  }
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0., 1.);
+
+  std::string ans;
+  for (int i = 0; i < requests; i++) {
+    double x = u(rng);
+    long a = long(x * x * x * double(max));
+    std::string req = std::to_string(a) + " " + std::to_string(a + len);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = request(fd, req, ans);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (!ok) {
+      c.errors += requests - i;
+      break;
+    }
+    if (long(ans.size()) != len || ans.compare(0, 5, "error") == 0)
+      c.errors++;
+    c.us.push_back(uint32_t(us));
+  }
+
+  close(fd);
+}
+
+
+static void usage()
+{
+  printf("usage: piload [options]\n");
+  printf("  --socket PATH      piserve's Unix domain socket\n");
+  printf("  --port N           or its localhost TCP port\n");
+  printf("  --clients N        connections at once (default 8)\n");
+  printf("  --requests N       requests per client (default 1000)\n");
+  printf("  --len N            digits per request (default 64)\n");
+  printf("  --max N            highest starting digit (default 20000)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  int clients = 8;
+  int requests = 1000;
+  long len = 64;
+  long max = 20000;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--socket") == 0 && val) {
+      socket_path = val; i++;
+    } else if (strcmp(arg, "--port") == 0 && val) {
+      port = atoi(val); i++;
+    } else if (strcmp(arg, "--clients") == 0 && val) {
+      clients = atoi(val); i++;
+    } else if (strcmp(arg, "--requests") == 0 && val) {
+      requests = atoi(val); i++;
+    } else if (strcmp(arg, "--len") == 0 && val) {
+      len = atol(val); i++;
+    } else if (strcmp(arg, "--max") == 0 && val) {
+      max = atol(val); i++;
+    } else {
+      usage();
+      return strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if ((socket_path == nullptr) == (port == 0) || clients < 1 || len < 1) {
+    usage();
+    return 1;
+  }
+
+  std::vector<Client> c(clients);
+  std::vector<std::thread> t;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < clients; i++)
+    t.emplace_back(run_client, std::ref(c[i]), unsigned(i + 1), requests, len,
+                   max);
+  for (auto& th : t)
+    th.join();
+  double s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  std::vector<uint32_t> us;
+  long errors = 0;
+  for (auto& cl : c) {
+    us.insert(us.end(), cl.us.begin(), cl.us.end());
+    errors += cl.errors;
+  }
+  std::sort(us.begin(), us.end());
+
+  printf("%zu requests in %.2f s (%.0f/s), %ld error(s)\n", us.size(), s,
+         s > 0. ? double(us.size()) / s : 0., errors);
+  if (!us.empty())
+    printf("latency: p50 %u us, p99 %u us, max %u us\n", us[us.size() / 2],
+           us[(us.size() - 1) * 99 / 100], us.back());
+
+  int fd = connect_server();
+  std::string ans;
+  if (fd >= 0 && request(fd, "stats", ans))
+    printf("server: %s\n", ans.c_str());
+  if (fd >= 0)
+    close(fd);
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,335 @@
+// piserve: digits of pi on request, for dashboards and the kiosk display.
+//
+//   build/piserve --store pi.txt --socket /tmp/piserve.sock
+//   build/piserve --store pi.txt --port 3141
+//
+// One request per line, one answer per line:
+//   "<a> <b>"   digits [a, b) (the '3' is 0), e.g. "0 5" -> "31415"
+//   "find <s>"  where the digits s first turn up in the store (the first
+//               digit's number), or "none"; e.g. "find 0714" -> "9545"
+//   "stats"     counts and latencies, as name=value pairs
+// Anything wrong gets "error <why>", including digits more than --compute
+// past the end of the store. Requests on one connection are answered in
+// order; any number of connections can be open at once.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "digit_service.h"
+#include "digit_store.h"
+#include "search_index.h"
+
+// longest request, in digits
+static const long max_request = 1000000;
+
+// longest string to find
+static const int max_find = 64;
+
+// how far past the end of the store to compute digits (--compute); beyond
+// that a block takes so long that a few requests would tie up every thread
+static long compute_past = 25000;
+
+static DigitService *service;
+static DigitStore *digits;
+static SearchIndex *search;   // null if there's no store
+static std::atomic<uint64_t> finds(0);
+
+
+// pidec wants micros() for its optional stage timings; this isn't the
+// simulator, so it's just the host clock.
+uint32_t micros()
+{
+  using namespace std::chrono;
+  return uint32_t(duration_cast<microseconds>(
+      steady_clock::now().time_since_epoch()).count());
+}
+
+
+static bool send_all(int fd, const char *p, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+
+static std::string stats_line()
+{
+  DigitService::Stats s = service->stats();
+  uint64_t blocks = s.cache_hits + s.computed + s.coalesced;
+  char buf[400];
+  snprintf(buf, sizeof(buf),
+           "requests=%llu digits=%llu store_digits=%llu cache_hits=%llu "
+           "computed=%llu coalesced=%llu evicted=%llu compute_ms=%llu "
+           "hit_rate=%.3f p50_us=%u p99_us=%u finds=%llu indexed=%ld\n",
+           (unsigned long long)s.requests, (unsigned long long)s.digits,
+           (unsigned long long)s.store_digits,
+           (unsigned long long)s.cache_hits, (unsigned long long)s.computed,
+           (unsigned long long)s.coalesced, (unsigned long long)s.evicted,
+           (unsigned long long)(s.compute_us / 1000),
+           blocks > 0 ? double(s.cache_hits + s.coalesced) / double(blocks) : 0.,
+           s.p50_us, s.p99_us, (unsigned long long)finds.load(),
+           search != nullptr ? search->end() - 1 : 0L);
+  return buf;
+}
+
+
+static std::string answer(const char *req)
+{
+  if (strcmp(req, "stats") == 0)
+    return stats_line();
+
+  if (strncmp(req, "find ", 5) == 0) {
+    const char *s = req + 5;
+    int len = int(strlen(s));
+    if (len < 1 || len > max_find || int(strspn(s, "0123456789")) != len)
+      return "error find wants 1 to " + std::to_string(max_find) + " digits\n";
+    if (search == nullptr)
+      return "error no store to search\n";
+    finds++;
+    long num = search->find(s, len);
+    return num < 0 ? "none\n" : std::to_string(num) + "\n";
+  }
+
+  long a, b;
+  char extra;
+  if (sscanf(req, "%ld %ld %c", &a, &b, &extra) != 2)
+    return "error expected \"<a> <b>\", \"find <digits>\", or \"stats\"\n";
+  if (a < 0 || b < a)
+    return "error need 0 <= a <= b\n";
+  if (b - a > max_request)
+    return "error at most " + std::to_string(max_request) + " digits at a time\n";
+  const long last = digits->end() + compute_past;
+  if (b > last)
+    return "error only digits before " + std::to_string(last) + "\n";
+
+  std::string out(b - a + 1, '\n');
+  service->get(a, b, &out[0]);
+  return out;
+}
+
+
+static void serve(int fd)
+{
+  std::string in;
+  char buf[4096];
+
+  while (true) {
+
+    size_t nl;
+    while ((nl = in.find('\n')) == std::string::npos) {
+      if (in.size() > 256) {
+        send_all(fd, "error line too long\n", 20);
+        close(fd);
+        return;
+      }
+      ssize_t n = recv(fd, buf, sizeof(buf), 0);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0) {
+        close(fd);
+        return;
+      }
+      in.append(buf, n);
+    }
+
+    std::string req = in.substr(0, nl);
+    in.erase(0, nl + 1);
+    if (!req.empty() && req.back() == '\r')
+      req.pop_back();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string out = answer(req.c_str());
+    bool ok = send_all(fd, out.data(), out.size());
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    service->latency.add(uint32_t(us));
+
+    if (!ok) {
+      close(fd);
+      return;
+    }
+  }
+}
+
+
+static int listen_unix(const char *path)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: path too long\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    perror(path);
+    return -1;
+  }
+  return fd;
+}
+
+
+static int listen_tcp(int port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // this machine only
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    perror("bind");
+    return -1;
+  }
+  return fd;
+}
+
+
+static void usage()
+{
+  printf("usage: piserve [options]\n");
+  printf("  --socket PATH      listen on a Unix domain socket\n");
+  printf("  --port N           listen on localhost TCP port N\n");
+  printf("  --store FILE       digits already worked out (see digit_store.h)\n");
+  printf("  --compute N        digits past the end of the store to compute (default %ld)\n",
+         compute_past);
+  printf("  --cache-blocks N   computed blocks of %d digits to keep (default 16384)\n",
+         DigitService::block_len);
+  printf("  --shards N         cache shards (default 16)\n");
+  printf("  --threads N        threads to index the store with (default: all)\n");
+  printf("  --index-every SEC  look for digits added to the store (default 10)\n");
+  printf("  --stats SEC        print stats every SEC seconds\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *socket_path = nullptr;
+  int port = 0;
+  const char *store_path = nullptr;
+  long cache_blocks = 16384;
+  int shards = 16;
+  int stats_sec = 0;
+  int threads = int(std::thread::hardware_concurrency());
+  int index_sec = 10;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--socket") == 0 && val) {
+      socket_path = val; i++;
+    } else if (strcmp(arg, "--port") == 0 && val) {
+      port = atoi(val); i++;
+    } else if (strcmp(arg, "--store") == 0 && val) {
+      store_path = val; i++;
+    } else if (strcmp(arg, "--compute") == 0 && val) {
+      compute_past = atol(val); i++;
+    } else if (strcmp(arg, "--cache-blocks") == 0 && val) {
+      cache_blocks = atol(val); i++;
+    } else if (strcmp(arg, "--shards") == 0 && val) {
+      shards = atoi(val); i++;
+    } else if (strcmp(arg, "--threads") == 0 && val) {
+      threads = atoi(val); i++;
+    } else if (strcmp(arg, "--index-every") == 0 && val) {
+      index_sec = atoi(val); i++;
+    } else if (strcmp(arg, "--stats") == 0 && val) {
+      stats_sec = atoi(val); i++;
+    } else {
+      usage();
+      return strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if ((socket_path == nullptr) == (port == 0) || cache_blocks < 1 || shards < 1 ||
+      compute_past < 0) {
+    usage();
+    return 1;
+  }
+
+  DigitStore store;
+  if (store_path != nullptr && !store.open(store_path))
+    return 1;
+  digits = &store;
+
+  DigitService svc(store, cache_blocks, shards);
+  service = &svc;
+
+  SearchIndex index(store, threads);
+  if (store_path != nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    index.extend();
+    printf("piserve: indexed in %.2f s, %zu MB\n",
+           std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start).count(),
+           index.bytes() >> 20);
+    search = &index;
+  }
+
+  int fd = socket_path != nullptr ? listen_unix(socket_path) : listen_tcp(port);
+  if (fd < 0 || listen(fd, 64) != 0) {
+    perror("listen");
+    return 1;
+  }
+
+  printf("piserve: %ld digits in store, listening on %s%s\n", store.end(),
+         socket_path != nullptr ? socket_path : "port ",
+         socket_path != nullptr ? "" : std::to_string(port).c_str());
+  fflush(stdout);
+
+  if (search != nullptr && index_sec > 0) {
+    std::thread([&store, index_sec]() {
+      while (true) {
+        sleep(index_sec);
+        if (store.refresh())
+          search->extend();
+      }
+    }).detach();
+  }
+
+  if (stats_sec > 0) {
+    std::thread([stats_sec]() {
+      while (true) {
+        sleep(stats_sec);
+        fputs(stats_line().c_str(), stdout);
+        fflush(stdout);
+      }
+    }).detach();
+  }
+
+  while (true) {
+    int c = accept(fd, nullptr, nullptr);
+    if (c < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      perror("accept");
+      return 1;
+    }
+    std::thread(serve, c).detach();
+  }
+}
@@ -0,0 +1,273 @@
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include "search_index.h"
+
+// first-level buckets are the first 3 digits of the gram
+static const long num_buckets = 1000;
+
+
+// Run fn(0) .. fn(n - 1) on n threads and wait for them.
+template <typename F>
+static void parallel(int n, F fn)
+{
+  std::vector<std::thread> t;
+  for (int i = 1; i < n; i++)
+    t.emplace_back(fn, i);
+  fn(0);
+  for (auto& th : t)
+    th.join();
+}
+
+
+// fn(i, gram) for each i in [a, b) where the gram_len digits d[i..] are
+// all digits (so d[a .. b + gram_len - 1) has to be there).
+template <typename F>
+static void for_grams(const char *d, long a, long b, F fn)
+{
+  const int k = SearchIndex::gram_len;
+  uint32_t g = 0;
+  int run = 0;  // digits in a row up to d[i]
+  for (long i = a; i < b + k - 1; i++) {
+    unsigned c = unsigned(d[i]) - '0';
+    if (c > 9) {
+      run = 0;
+      continue;
+    }
+    g = (g * 10 + c) % SearchIndex::num_grams;
+    if (++run >= k)
+      fn(i - (k - 1), g);
+  }
+}
+
+
+SearchIndex::SearchIndex(const DigitStore& store, int threads) :
+  _store(store),
+  _threads(threads > 0 ? threads : 1),
+  _end(1)
+{
+  long n = 1;
+  for (int len = 1; len <= gram_len; len++) {
+    n *= 10;
+    _first[len].assign(n, none);
+  }
+}
+
+
+long SearchIndex::extend(long limit)
+{
+  long end = _store.end();
+  if (limit >= 0 && limit < end)
+    end = limit;
+  long hi = end - (gram_len - 1);   // grams start below this
+
+  // (only this changes _segments, so no need to lock to look)
+  long done = _segments.empty() ? 1 : _segments.back()->hi;
+  if (hi <= done)
+    return 0;
+  long lo = done;
+  bool redo = false;
+  if (!_segments.empty() && done - _segments.back()->lo < segment_len) {
+    lo = _segments.back()->lo;
+    redo = true;
+  }
+
+  std::vector<std::unique_ptr<Segment>> built;
+  for (long a = lo; a < hi; a += segment_len) {
+    std::unique_ptr<Segment> seg(new Segment);
+    seg->lo = a;
+    seg->hi = hi - a < segment_len ? hi : a + segment_len;
+    build(*seg);
+    built.push_back(std::move(seg));
+  }
+
+  std::unique_lock<std::shared_mutex> lock(_lock);
+  if (redo)
+    _segments.pop_back();
+  for (auto& seg : built) {
+    update_first(*seg);
+    _segments.push_back(std::move(seg));
+  }
+  update_short(end);
+  _end = end;
+
+  return hi - done;
+}
+
+
+void SearchIndex::build(Segment& seg) const
+{
+  const long n = seg.hi - seg.lo;
+  const char *d = _store.at(seg.lo);
+
+  // not worth a thread for less than this
+  int threads = int(n / 65536) + 1;
+  if (threads > _threads)
+    threads = _threads;
+
+  auto slice = [n, threads](int t, long *a, long *b) {
+    *a = n * t / threads;
+    *b = n * (t + 1) / threads;
+  };
+
+  // 1: how many in each bucket, from each thread's slice
+  std::vector<std::vector<uint32_t>> next(threads,
+                                          std::vector<uint32_t>(num_buckets));
+  parallel(threads, [&](int t) {
+    long a, b;
+    slice(t, &a, &b);
+    uint32_t *count = next[t].data();
+    for_grams(d, a, b, [count](long, uint32_t g) {
+      count[g / 1000]++;
+    });
+  });
+
+  // where each thread's part of each bucket goes: bucket by bucket, and
+  // within one, slice by slice, so each stays in order
+  std::vector<uint32_t> bucket(num_buckets + 1);
+  uint32_t total = 0;
+  for (long h = 0; h < num_buckets; h++) {
+    bucket[h] = total;
+    for (int t = 0; t < threads; t++) {
+      uint32_t c = next[t][h];
+      next[t][h] = total;
+      total += c;
+    }
+  }
+  bucket[num_buckets] = total;
+
+  // 2: into buckets, with the rest of the gram for the next level
+  struct Item {
+    uint32_t pos;
+    uint32_t low;
+  };
+  std::vector<Item> items(total);
+  parallel(threads, [&](int t) {
+    long a, b;
+    slice(t, &a, &b);
+    uint32_t *at = next[t].data();
+    Item *out = items.data();
+    for_grams(d, a, b, [at, out](long i, uint32_t g) {
+      out[at[g / 1000]++] = Item{ uint32_t(i), g % 1000 };
+    });
+  });
+
+  // 3: each bucket by the rest of the gram, buckets split between threads
+  seg.start.resize(num_grams + 1);
+  seg.pos.resize(total);
+  parallel(threads, [&](int t) {
+    uint32_t count[1000];
+    for (long h = num_buckets * t / threads;
+         h < num_buckets * (t + 1) / threads; h++) {
+      memset(count, 0, sizeof(count));
+      for (uint32_t i = bucket[h]; i < bucket[h + 1]; i++)
+        count[items[i].low]++;
+      uint32_t at = bucket[h];
+      for (int l = 0; l < 1000; l++) {
+        seg.start[h * 1000 + l] = at;
+        uint32_t c = count[l];
+        count[l] = at;
+        at += c;
+      }
+      for (uint32_t i = bucket[h]; i < bucket[h + 1]; i++)
+        seg.pos[count[items[i].low]++] = items[i].pos;
+    }
+  });
+  seg.start[num_grams] = total;
+}
+
+
+// Grams first seen in this segment. Lock held.
+void SearchIndex::update_first(const Segment& seg)
+{
+  std::vector<long>& first = _first[gram_len];
+  for (long g = 0; g < num_grams; g++)
+    if (first[g] == none && seg.start[g] < seg.start[g + 1])
+      first[g] = seg.lo + seg.pos[seg.start[g]];
+}
+
+
+// The shorter strings' first occurrences, from the grams': n digits first
+// start where some n + 1 do, or right at the end. Lock held.
+void SearchIndex::update_short(long end)
+{
+  long n = num_grams;
+  for (int len = gram_len - 1; len >= 1; len--) {
+    n /= 10;
+    const std::vector<long>& longer = _first[len + 1];
+    std::vector<long>& shorter = _first[len];
+    for (long x = 0; x < n; x++) {
+      long m = none;
+      for (long y = x * 10; y < x * 10 + 10; y++)
+        if (longer[y] != none && (m == none || longer[y] < m))
+          m = longer[y];
+      shorter[x] = m;
+    }
+    long tail = end - len;
+    int c = tail >= 1 ? code(tail, len) : -1;
+    if (c >= 0 && shorter[c] == none)
+      shorter[c] = tail;
+  }
+}
+
+
+// the len digits at num as a number, or -1 if they aren't all digits
+int SearchIndex::code(long num, int len) const
+{
+  const char *d = _store.at(num);
+  int c = 0;
+  for (int i = 0; i < len; i++) {
+    unsigned v = unsigned(d[i]) - '0';
+    if (v > 9)
+      return -1;
+    c = c * 10 + int(v);
+  }
+  return c;
+}
+
+
+long SearchIndex::find(const char *s, int len) const
+{
+  if (len < 1)
+    return none;
+
+  int k = len < gram_len ? len : gram_len;
+  int c = 0;
+  for (int i = 0; i < k; i++)
+    c = c * 10 + (s[i] - '0');
+
+  std::shared_lock<std::shared_mutex> lock(_lock);
+
+  if (len <= gram_len)
+    return _first[len][c];
+
+  for (auto& seg : _segments) {
+    for (uint32_t i = seg->start[c]; i < seg->start[c + 1]; i++) {
+      long num = seg->lo + seg->pos[i];
+      if (num + len > _end)
+        return none; // the rest are later still
+      if (memcmp(_store.at(num + gram_len), s + gram_len, len - gram_len) == 0)
+        return num;
+    }
+  }
+  return none;
+}
+
+
+long SearchIndex::end() const
+{
+  std::shared_lock<std::shared_mutex> lock(_lock);
+  return _end;
+}
+
+
+size_t SearchIndex::bytes() const
+{
+  std::shared_lock<std::shared_mutex> lock(_lock);
+  size_t n = 0;
+  for (auto& seg : _segments)
+    n += (seg->start.size() + seg->pos.size()) * sizeof(uint32_t);
+  for (int len = 1; len <= gram_len; len++)
+    n += _first[len].size() * sizeof(long);
+  return n;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Where a string of digits first turns up in the DigitStore ("where is my
+// birthday in pi?"), without reading through the store to find out.
+//
+// The 6 digits starting at a position are its gram, a number below 10^6.
+// The index is a run of segments, each covering a range of positions and
+// holding, for every gram, the positions in that range where it starts, in
+// order: one array of positions grouped by gram, and where each group
+// starts. A string of 6 or more digits first turns up at the first of its
+// gram's positions, in the first segment, where the rest matches too;
+// there are about (segment length) / 10^6 to look at per segment. Shorter
+// strings go in tables of first occurrence, one per length, worked out
+// from the 6-digit one.
+//
+// extend() indexes what the store has gained. A segment is built by a
+// counting sort in two levels (first 3 digits, then the last 3, so each
+// pass's counts fit in L1), split between threads. Only the last segment
+// can be short; it is built again along with what's new until it's full,
+// so extending costs at most a segment's worth more than the new digits.
+//
+// Searching starts at num 1, the first digit after the decimal point (as
+// pi searches usually do). Answers are in the store's numbering.
+
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include <stdint.h>
+#include "digit_store.h"
+
+class SearchIndex {
+
+  public:
+
+    static const int gram_len = 6;
+    static const long num_grams = 1000000;  // 10^gram_len
+
+    // positions per segment
+    static const long segment_len = 1L << 22;
+
+    SearchIndex(const DigitStore& store, int threads);
+
+    // Index the store up to 'limit' (or all of it). Returns how many
+    // positions were added. One thread at a time; find() can go on in
+    // others.
+    long extend(long limit = -1);
+
+    // First num >= 1 where the len digits s start, or -1 if they aren't in
+    // the store (as far as it's indexed). s is all '0'..'9'.
+    long find(const char *s, int len) const;
+
+    // strings are found if they end before this
+    long end() const;
+
+    // memory used, roughly
+    size_t bytes() const;
+
+  private:
+
+    struct Segment {
+      long lo;                      // positions [lo, hi)
+      long hi;
+      std::vector<uint32_t> start;  // gram g is pos[start[g]..start[g + 1])
+      std::vector<uint32_t> pos;    // less lo
+    };
+
+    const DigitStore& _store;
+    int _threads;
+
+    mutable std::shared_mutex _lock;
+    std::vector<std::unique_ptr<Segment>> _segments;
+    // _first[n][code]: first num where those n digits start, or none
+    std::vector<long> _first[gram_len + 1];
+    long _end;
+
+    static const long none = -1;
+
+    void build(Segment& seg) const;
+    void update_first(const Segment& seg);
+    void update_short(long end);
+    int code(long num, int len) const;
+};
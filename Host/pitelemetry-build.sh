@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Build the telemetry exporter (Host/pitelemetry).
+#
+#   ./pitelemetry-build.sh
+#
+# The result is build/pitelemetry; run it with --help. It uses the
+# library's telemetry.h (and the CRC from checkpoint.cpp), but not the
+# simulator.
+
+set -e
+
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-O2 -g -std=gnu++17 -Wall"}
+
+lib=../Arduino/libraries/PiMachine
+
+mkdir -p build
+
+# (the library has a sched.h; system headers come first)
+$CXX $CXXFLAGS -Ihal -idirafter "$lib" \
+    pitelemetry/pitelemetry.cpp "$lib"/checkpoint.cpp \
+    -o build/pitelemetry
+
+echo "build/pitelemetry"
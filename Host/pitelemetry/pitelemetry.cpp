@@ -0,0 +1,216 @@
+// pitelemetry: what a Pi Machine's telemetry (telemetry.h) says about how
+// the cost of a digit grows with n.
+//
+//   build/pitelemetry flash.bin
+//   build/pitelemetry --csv dump.txt > cost.csv
+//
+// The input is a flash image (the simulator's --flash file) or what the
+// TelemetryDump sketch printed. It prints a line per bucket of digit
+// positions: digits computed, their average and standard deviation of
+// compute time, time waiting for power and paper, outs and digits backed up
+// over. Sums are decayed to the time of the image, as the machine would.
+//
+// Then it fits cost = a * n^b to the average cost of the buckets from
+// --fit-from on, weighted by digits, and says where that reaches --slow
+// seconds a digit (one a minute, by default).
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <telemetry.h>
+
+
+static bool read_file(const char *path, std::vector<uint8_t>& data)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == nullptr) {
+    perror(path);
+    return false;
+  }
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+
+// TelemetryDump's lines: "telemetry <offset> <hex bytes>"
+static bool from_dump(const std::vector<uint8_t>& data, Telemetry::Image& img)
+{
+  std::string text(data.begin(), data.end());
+  std::vector<uint8_t> bytes(sizeof(img), 0);
+  size_t got = 0;
+  size_t at = 0;
+  while ((at = text.find("telemetry ", at)) != std::string::npos) {
+    at += strlen("telemetry ");
+    char *end;
+    unsigned long off = strtoul(text.c_str() + at, &end, 16);
+    if (end == text.c_str() + at || *end != ' ')
+      continue;
+    const char *p = end + 1;
+    while (isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]) &&
+           off < bytes.size()) {
+      char hex[3] = { p[0], p[1], '\0' };
+      bytes[off++] = uint8_t(strtoul(hex, nullptr, 16));
+      got++;
+      p += 2;
+    }
+  }
+  if (got < sizeof(img))
+    return false;
+  memcpy(&img, bytes.data(), sizeof(img));
+  return Telemetry::valid(img);
+}
+
+
+// the newest valid image anywhere in a flash image (they start on sector
+// boundaries)
+static bool from_flash(const std::vector<uint8_t>& data, Telemetry::Image& img)
+{
+  const size_t sector = 4096;
+  bool found = false;
+  for (size_t off = 0; off + sizeof(img) <= data.size(); off += sector) {
+    Telemetry::Image t;
+    memcpy(&t, data.data() + off, sizeof(t));
+    if (Telemetry::valid(t) && (!found || t.seq > img.seq)) {
+      img = t;
+      found = true;
+    }
+  }
+  return found;
+}
+
+
+static void usage()
+{
+  printf("usage: pitelemetry [options] FILE\n");
+  printf("  FILE               flash image (simulator --flash) or TelemetryDump output\n");
+  printf("  --csv              buckets as CSV, no fit\n");
+  printf("  --fit-from N       fit buckets from digit N on (default 1000)\n");
+  printf("  --slow S           say where a digit takes S seconds (default 60)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *path = nullptr;
+  bool csv = false;
+  double fit_from = 1000.;
+  double slow_s = 60.;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--csv") == 0) {
+      csv = true;
+    } else if (strcmp(arg, "--fit-from") == 0 && val) {
+      fit_from = atof(val); i++;
+    } else if (strcmp(arg, "--slow") == 0 && val) {
+      slow_s = atof(val); i++;
+    } else if (arg[0] != '-' && path == nullptr) {
+      path = arg;
+    } else {
+      usage();
+      return strcmp(arg, "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  if (path == nullptr) {
+    usage();
+    return 1;
+  }
+
+  std::vector<uint8_t> data;
+  if (!read_file(path, data))
+    return 1;
+
+  static Telemetry::Image img;
+  if (!from_dump(data, img) && !from_flash(data, img)) {
+    fprintf(stderr, "%s: no telemetry in it\n", path);
+    return 1;
+  }
+
+  const uint32_t now = uint32_t(img.run_ms / 60000);
+  for (int b = 0; b < Telemetry::num_buckets; b++)
+    Telemetry::decay_to(img.bucket[b], now);
+
+  if (csv)
+    printf("n_lo,n_hi,digits,mean_s,sd_s,power_s,paper_s,outs,backed_up\n");
+  else
+    printf("%.1f hours running, %u saves, half-life %u hours\n\n"
+           "      digits from-to   digits   mean s     sd s  power s  paper s"
+           "   outs  back\n",
+           double(img.run_ms) / 3600000., img.seq,
+           unsigned(Telemetry::half_life_min / 60));
+
+  // weighted least squares of log(mean) on log(n)
+  double sw = 0., sx = 0., sy = 0., sxx = 0., sxy = 0.;
+  double total_digits = 0., total_compute = 0., total_wait = 0.;
+  long last_lo = -1;
+  double last_mean = 0.;
+
+  for (int b = 0; b < Telemetry::num_buckets; b++) {
+    const Telemetry::Bucket& k = img.bucket[b];
+    if (k.digits <= 0.f && k.outs <= 0.f)
+      continue;
+    long lo = long(Telemetry::bucket_lo(b));
+    long hi = long(Telemetry::bucket_lo(b + 1)) - 1;
+    double mean = k.digits > 0.f ? k.compute_s / k.digits : 0.;
+    double var = k.digits > 0.f ? k.compute_s2 / k.digits - mean * mean : 0.;
+    double sd = var > 0. ? sqrt(var) : 0.;
+
+    if (csv)
+      printf("%ld,%ld,%.2f,%.6f,%.6f,%.1f,%.1f,%.2f,%.1f\n", lo, hi,
+             k.digits, mean, sd, k.power_s, k.paper_s, k.outs, k.backed_up);
+    else
+      printf("%9ld-%-9ld %8.1f %8.4f %8.4f %8.0f %8.0f %6.1f %5.0f\n", lo, hi,
+             k.digits, mean, sd, k.power_s, k.paper_s, k.outs, k.backed_up);
+
+    total_digits += k.digits;
+    total_compute += k.compute_s;
+    total_wait += k.power_s + k.paper_s;
+
+    if (k.digits > 0.f) {
+      last_lo = lo;
+      last_mean = mean;
+    }
+
+    if (k.digits >= 1.f && mean > 0. && lo >= fit_from) {
+      double x = log(0.5 * (double(lo) + double(hi)));
+      double y = log(mean);
+      double w = k.digits;
+      sw += w;
+      sx += w * x;
+      sy += w * y;
+      sxx += w * x * x;
+      sxy += w * x * y;
+    }
+  }
+
+  if (csv)
+    return 0;
+
+  printf("\n%.0f digits computed in %.1f hours, %.1f hours waiting (decayed)\n",
+         total_digits, total_compute / 3600., total_wait / 3600.);
+  if (last_lo >= 0)
+    printf("latest: %.3f s a digit from n = %ld\n", last_mean, last_lo);
+
+  double det = sw * sxx - sx * sx;
+  if (sw <= 0. || det <= 1e-9 * sw * sw) {
+    printf("not enough from n = %.0f on to fit\n", fit_from);
+    return 0;
+  }
+  double b = (sw * sxy - sx * sy) / det;
+  double a = exp((sy - b * sx) / sw);
+  printf("fit from n = %.0f: cost = %.3g * n^%.3f s\n", fit_from, a, b);
+  if (b > 0.)
+    printf("%.0f s a digit at n = %.3g\n", slow_s, pow(slow_s / a, 1. / b));
+
+  return 0;
+}
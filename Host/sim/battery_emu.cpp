@@ -0,0 +1,84 @@
+#include "battery_emu.h"
+
+// Open-circuit voltage by charge left, for a typical LiPo.
+static const struct {
+  double pct;
+  int mv;
+} ocv[] = {
+  { 100, 4180 }, { 90, 4060 }, { 80, 3970 }, { 70, 3900 }, { 60, 3840 },
+  { 50, 3800 }, { 40, 3770 }, { 30, 3730 }, { 20, 3690 }, { 10, 3620 },
+  { 5, 3500 }, { 0, 3200 },
+};
+static const int ocv_num = sizeof(ocv) / sizeof(ocv[0]);
+
+
+BatteryEmu::BatteryEmu() :
+  lowest_mv(0),
+  _capacity_mas(0.),
+  _start_pct(100.),
+  _used_mas(0.),
+  _mohm(500.),
+  _cutoff_mv(3000),
+  _cut_off(false)
+{
+}
+
+
+void BatteryEmu::capacity_mah(double mah)
+{
+  _capacity_mas = mah * 3600.;
+  charge_pct(_start_pct);
+}
+
+
+void BatteryEmu::charge_pct(double pct)
+{
+  _start_pct = pct;
+  _used_mas = _capacity_mas * (100. - pct) / 100.;
+}
+
+
+void BatteryEmu::resistance_mohm(double mohm)
+{
+  _mohm = mohm;
+}
+
+
+void BatteryEmu::cutoff_mv(int mv)
+{
+  _cutoff_mv = mv;
+}
+
+
+double BatteryEmu::charge_pct() const
+{
+  if (_capacity_mas <= 0.)
+    return 0.;
+  double pct = 100. * (_capacity_mas - _used_mas) / _capacity_mas;
+  return pct > 0. ? pct : 0.;
+}
+
+
+int BatteryEmu::open_mv() const
+{
+  double pct = charge_pct();
+  for (int i = 1; i < ocv_num; i++) {
+    if (pct >= ocv[i].pct) {
+      double f = (pct - ocv[i].pct) / (ocv[i - 1].pct - ocv[i].pct);
+      return ocv[i].mv + int(f * (ocv[i - 1].mv - ocv[i].mv));
+    }
+  }
+  return ocv[ocv_num - 1].mv;
+}
+
+
+int BatteryEmu::drain(double charge, double ma, double peak_ma)
+{
+  _used_mas += charge / 1e6;
+  int low = open_mv() - int(peak_ma * _mohm / 1000.);
+  if (lowest_mv == 0 || low < lowest_mv)
+    lowest_mv = low;
+  if (low < _cutoff_mv)
+    _cut_off = true;
+  return open_mv() - int(ma * _mohm / 1000.);
+}
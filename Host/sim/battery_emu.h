@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// A lithium cell (the Tiny's), for seeing how far a charge goes. Its
+// open-circuit voltage falls as charge is used; what the sketch reads is
+// that less the current times the internal resistance, so it sags while
+// the printer heats. If that ever goes under the protection cutoff, the
+// cell disconnects and everything goes off, mid-line.
+class BatteryEmu {
+
+  public:
+
+    BatteryEmu();
+
+    // turns it on
+    void capacity_mah(double mah);
+    bool enabled() const { return _capacity_mas > 0.; }
+
+    void charge_pct(double pct);        // to start with (default 100)
+    void resistance_mohm(double mohm);  // default 500
+    void cutoff_mv(int mv);             // default 3000
+
+    // Take out 'charge' (mA * usec) used since the last call, during which
+    // the current got as high as peak_ma and is now ma. Returns the voltage
+    // now.
+    int drain(double charge, double ma, double peak_ma);
+
+    double charge_pct() const;
+    bool cut_off() const { return _cut_off; }
+
+    // statistics
+    int lowest_mv;
+
+  private:
+
+    double _capacity_mas;   // mA * sec
+    double _start_pct;
+    double _used_mas;
+    double _mohm;
+    int _cutoff_mv;
+    bool _cut_off;
+
+    int open_mv() const;
+};
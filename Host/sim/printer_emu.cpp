@@ -0,0 +1,288 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <hal.h>
+#include "printer_emu.h"
+
+// How printing a line turns into time and current. Each line is 48 dot
+// rows; a row of text has about 6 dots per (non-blank) character, and
+// the sideways digit about 24. A row is heated (dots + 1) * 8 dots at a
+// time, each taking the heat time plus the interval, at 20 mA a dot. The
+// motor and logic draw the rest.
+static const int rows_per_line = 48;
+static const int dots_per_char = 6;
+static const int dots_per_digit = 24;
+static const double ma_per_dot = 20.;
+static const double printing_ma = 200.;
+static const double idle_ma = 40.;
+
+
+PrinterEmu::PrinterEmu() :
+  lines_printed(0),
+  lines_lost(0),
+  bytes_dropped(0),
+  status_queries(0),
+  status_reports(0),
+  _power(true),
+  _paper(true),
+  _latency_us(8300),
+  _boot_us(0),
+  _ready_us(0),
+  _cmd_len(0),
+  _rotate(false),
+  _heat_start_us(0),
+  _heat_end_us(0),
+  _heat_ma(0.),
+  _asb_supported(true),
+  _asb(0),
+  _on_line(nullptr)
+{
+  reset();
+}
+
+
+void PrinterEmu::boot_us(uint32_t us)
+{
+  _boot_us = us;
+  if (_power)
+    _ready_us = hal::now_us() + us;
+}
+
+
+void PrinterEmu::power(bool on)
+{
+  update();
+  if (on && !_power) {
+    reset(); // it boots up fresh
+    _asb = 0;
+    _ready_us = hal::now_us() + _boot_us;
+  }
+  if (!on) {
+    _responses.clear();
+    for (Line& line : _waiting)
+      done(line, false);
+    _waiting.clear();
+  }
+  _power = on;
+}
+
+
+void PrinterEmu::paper(bool present)
+{
+  update();
+  bool changed = present != _paper;
+  _paper = present;
+  if (changed && _power && hal::now_us() >= _ready_us && (_asb & 0x08) != 0)
+    report();
+}
+
+
+void PrinterEmu::update()
+{
+  uint64_t now = hal::now_us();
+  while (!_waiting.empty() && _waiting.front().t_us <= now) {
+    done(_waiting.front(), _paper);
+    _waiting.pop_front();
+  }
+}
+
+
+void PrinterEmu::done(Line& line, bool on_paper)
+{
+  line.on_paper = on_paper;
+  if (on_paper)
+    lines_printed++;
+  else
+    lines_lost++;
+  if (_on_line != nullptr)
+    _on_line(line);
+}
+
+
+// GS a report: 0x10 (fixed bits), no errors, paper end (and near end) in
+// the third byte
+void PrinterEmu::report()
+{
+  status_reports++;
+  uint64_t t = hal::now_us() + _latency_us;
+  _responses.push_back({ t, 0x10 });
+  _responses.push_back({ t, 0x00 });
+  _responses.push_back({ t, uint8_t(_paper ? 0x00 : 0x0f) });
+  _responses.push_back({ t, 0x00 });
+}
+
+
+void PrinterEmu::reset()
+{
+  _cmd.clear();
+  _cmd_len = 0;
+  _rotate = false;
+  _heat_dots = 7; // defaults
+  _heat_time = 80;
+  _heat_interval = 2;
+  _line = Line();
+  _line.digit = 0;
+  _line.num = -1;
+}
+
+
+void PrinterEmu::rx(uint8_t b)
+{
+  update();
+
+  if (!_power || hal::now_us() < _ready_us) {
+    bytes_dropped++;
+    return;
+  }
+
+  if (_cmd.empty()) {
+    if (b == 0x1b || b == 0x10 || b == 0x1d) {
+      _cmd.push_back(b);
+      _cmd_len = 0; // not known until the second byte
+      return;
+    }
+    if (b == '\n') {
+      feed();
+    } else if (_rotate) {
+      _line.digit = char(b);
+    } else {
+      _line.text += (b == 0xb2) ? '|' : char(b);
+    }
+    return;
+  }
+
+  _cmd.push_back(b);
+
+  if (_cmd.size() == 2) {
+    switch ((_cmd[0] << 8) | _cmd[1]) {
+      case 0x1b40: _cmd_len = 2; break; // ESC @ reset
+      case 0x1b37: _cmd_len = 5; break; // ESC 7 n1 n2 n3 heat
+      case 0x1d61: _cmd_len = 3; break; // GS a n auto status
+      default:     _cmd_len = 3; break; // everything else printer.cpp uses
+    }
+  }
+
+  if (_cmd.size() == _cmd_len) {
+    command(_cmd);
+    _cmd.clear();
+  }
+}
+
+
+void PrinterEmu::command(const std::vector<uint8_t>& cmd)
+{
+  switch ((cmd[0] << 8) | cmd[1]) {
+
+    case 0x1b40: // ESC @
+      reset();
+      break;
+
+    case 0x1b56: // ESC V n - rotate
+      _rotate = (cmd[2] & 1) != 0;
+      break;
+
+    case 0x1b4a: // ESC J n - print and feed
+      feed();
+      break;
+
+    case 0x1b37: // ESC 7 n1 n2 n3 - heat
+      _heat_dots = cmd[2];
+      _heat_time = cmd[3];
+      _heat_interval = cmd[4];
+      break;
+
+    case 0x1004: { // DLE EOT n - real-time status
+      status_queries++;
+      uint8_t s = 0x12; // fixed bits
+      if (cmd[2] == 4 && !_paper)
+        s |= 0x6c; // paper near end and paper end
+      _responses.push_back({ hal::now_us() + _latency_us, s });
+      break;
+    }
+
+    case 0x1d61: // GS a n - automatic status back
+      if (!_asb_supported)
+        break;
+      _asb = cmd[2];
+      if ((_asb & 0x08) != 0)
+        report(); // the first one comes right away
+      break;
+
+    default: // mode, line spacing: nothing to emulate
+      break;
+  }
+}
+
+
+void PrinterEmu::feed()
+{
+  const char *t = _line.text.c_str();
+  if ('0' <= *t && *t <= '9')
+    _line.num = strtol(t, nullptr, 10);
+
+  // heating starts when the previous line is done
+  int row_dots = _line.digit != 0 ? dots_per_digit : 0;
+  for (char c : _line.text)
+    if (c != ' ')
+      row_dots += dots_per_char;
+  int at_once = (_heat_dots + 1) * 8;
+  int passes = (row_dots + at_once - 1) / at_once;
+  uint64_t us = uint64_t(rows_per_line) * passes *
+                (uint64_t(_heat_time) + _heat_interval) * 10;
+  uint64_t now = hal::now_us();
+  if (now < _heat_end_us) {
+    _heat_end_us += us;
+  } else {
+    _heat_start_us = now;
+    _heat_end_us = now + us;
+  }
+  _heat_ma = printing_ma + ma_per_dot * (row_dots < at_once ? row_dots : at_once);
+
+  _line.t_us = _heat_end_us - us;
+  _waiting.push_back(_line);
+  update();
+
+  _line = Line();
+  _line.digit = 0;
+  _line.num = -1;
+}
+
+
+double PrinterEmu::charge(uint64_t from_us, uint64_t to_us) const
+{
+  if (!_power || to_us <= from_us)
+    return 0.;
+  double q = idle_ma * double(to_us - from_us);
+  uint64_t a = from_us > _heat_start_us ? from_us : _heat_start_us;
+  uint64_t b = to_us < _heat_end_us ? to_us : _heat_end_us;
+  if (a < b)
+    q += _heat_ma * double(b - a);
+  return q;
+}
+
+
+double PrinterEmu::peak_ma(uint64_t from_us, uint64_t to_us) const
+{
+  if (!_power)
+    return 0.;
+  if (from_us < _heat_end_us && _heat_start_us < to_us)
+    return idle_ma + _heat_ma;
+  return idle_ma;
+}
+
+
+int PrinterEmu::tx_peek()
+{
+  update();
+  if (_responses.empty() || _responses.front().ready_us > hal::now_us())
+    return -1;
+  return _responses.front().b;
+}
+
+
+int PrinterEmu::tx_read()
+{
+  int b = tx_peek();
+  if (b != -1)
+    _responses.pop_front();
+  return b;
+}
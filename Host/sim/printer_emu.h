@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string>
+#include <deque>
+#include <vector>
+
+// Thermal printer on the other end of Serial1, as far as printer.cpp uses
+// it: mode/rotate/line-space commands are swallowed, text accumulates
+// until the line is fed (ESC J or newline), and real-time status requests
+// (DLE EOT n) are answered after a realistic delay.
+//
+// Heat settings (ESC 7) decide how long each line takes to print and how
+// much current that draws, for the battery (BatteryEmu).
+//
+// Lines print one after another, each when the one before it is done, so
+// several can be waiting in the printer. Whether a line ends up on the
+// paper is decided when it starts printing: with no paper, it is
+// "printed" but lost. With no power the printer is deaf and mute, and what
+// was waiting to print is gone.
+//
+// Automatic status back (GS a) reports paper out and paper back without
+// being asked, if it's turned on (and allowed: auto_status(false) makes
+// it firmware that doesn't do it).
+
+class PrinterEmu : public SerialDevice {
+
+  public:
+
+    struct Line {
+      uint64_t t_us;      // virtual time it started printing
+      std::string text;   // unrotated text, gray boxes shown as '|'
+      char digit;         // rotated character, 0 if none
+      long num;           // leading digit number, -1 if none
+      bool on_paper;
+    };
+
+    PrinterEmu();
+
+    void power(bool on);
+    void paper(bool present);
+
+    bool power() const { return _power; }
+    bool paper() const { return _paper; }
+
+    // status response delay (Mini is ~8 msec, Nano ~4 msec)
+    void latency_us(uint32_t us) { _latency_us = us; }
+
+    // After power comes on (including at the start), the printer ignores
+    // everything for this long while it boots.
+    void boot_us(uint32_t us);
+
+    // whether GS a works
+    void auto_status(bool supported) { _asb_supported = supported; }
+
+    // called for each line as it prints (or is lost)
+    void on_line(void (*cb)(const Line& line)) { _on_line = cb; }
+
+    // Deal with lines that have started printing by now. Everything else
+    // does this first; call it before looking at the statistics.
+    void update();
+
+    // Current drawn over virtual time [from_us, to_us), in mA * usec; the
+    // most drawn at any point in it; and at time t.
+    double charge(uint64_t from_us, uint64_t to_us) const;
+    double peak_ma(uint64_t from_us, uint64_t to_us) const;
+    double current_ma(uint64_t t_us) const { return peak_ma(t_us, t_us + 1); }
+
+    // SerialDevice
+    virtual void rx(uint8_t b);
+    virtual int tx_peek();
+    virtual int tx_read();
+
+    // statistics
+    uint32_t lines_printed;   // on paper
+    uint32_t lines_lost;      // printed with no paper, or lost with power
+    uint32_t bytes_dropped;   // sent with no power, or while booting
+    uint32_t status_queries;
+    uint32_t status_reports;  // automatic
+
+  private:
+
+    bool _power;
+    bool _paper;
+    uint32_t _latency_us;
+    uint32_t _boot_us;
+    uint64_t _ready_us;
+
+    // command parser
+    std::vector<uint8_t> _cmd;
+    size_t _cmd_len;
+
+    bool _rotate;
+    Line _line;
+
+    // ESC 7 n1 n2 n3
+    uint8_t _heat_dots;
+    uint8_t _heat_time;
+    uint8_t _heat_interval;
+
+    // printing a line: heating [_heat_start_us, _heat_end_us) at _heat_ma
+    uint64_t _heat_start_us;
+    uint64_t _heat_end_us;
+    double _heat_ma;
+
+    struct Response {
+      uint64_t ready_us;
+      uint8_t b;
+    };
+    std::deque<Response> _responses;
+
+    // GS a n
+    bool _asb_supported;
+    uint8_t _asb;
+
+    // fed and waiting to print, in order, with when each starts
+    std::deque<Line> _waiting;
+
+    void (*_on_line)(const Line& line);
+
+    void command(const std::vector<uint8_t>& cmd);
+    void feed();
+    void reset();
+    void done(Line& line, bool on_paper);
+    void report();
+
+};
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "script.h"
+
+
+bool parse_duration(const char *s, uint64_t& us)
+{
+  us = 0;
+  if (*s == '\0')
+    return false;
+
+  while (*s != '\0') {
+
+    if (!isdigit((unsigned char)*s))
+      return false;
+
+    char *end;
+    double v = strtod(s, &end);
+    s = end;
+
+    uint64_t unit_us;
+    if (strncmp(s, "ms", 2) == 0) {
+      unit_us = 1000ull;
+      s += 2;
+    } else if (*s == 's' || *s == '\0') {
+      unit_us = 1000000ull;
+      if (*s != '\0')
+        s++;
+    } else if (*s == 'm') {
+      unit_us = 60ull * 1000000ull;
+      s++;
+    } else if (*s == 'h') {
+      unit_us = 3600ull * 1000000ull;
+      s++;
+    } else if (*s == 'd') {
+      unit_us = 86400ull * 1000000ull;
+      s++;
+    } else {
+      return false;
+    }
+
+    us += uint64_t(v * double(unit_us));
+  }
+
+  return true;
+}
+
+
+bool load_script(const char *path, std::vector<Event>& events)
+{
+  FILE *f = fopen(path, "r");
+  if (f == nullptr) {
+    perror(path);
+    return false;
+  }
+
+  char buf[256];
+  int line = 0;
+  uint64_t last_us = 0;
+
+  while (fgets(buf, sizeof(buf), f) != nullptr) {
+
+    line++;
+
+    char *hash = strchr(buf, '#');
+    if (hash != nullptr)
+      *hash = '\0';
+
+    char t[64], what[64], a1[64], a2[64];
+    int n = sscanf(buf, "%63s %63s %63s %63s", t, what, a1, a2);
+    if (n <= 0)
+      continue; // blank
+
+    Event ev;
+    ev.line = line;
+    ev.arg1 = 0;
+    ev.arg2 = 0;
+
+    bool ok = (n >= 2) && parse_duration(t, ev.t_us);
+
+    if (ok) {
+      ev.what = what;
+      // arg1 is 1 for on/in, 0 for off/out
+      if (ev.what == "power") {
+        ok = (n == 3) && (strcmp(a1, "on") == 0 || strcmp(a1, "off") == 0);
+        ev.arg1 = ok && strcmp(a1, "on") == 0;
+      } else if (ev.what == "paper") {
+        ok = (n == 3) && (strcmp(a1, "in") == 0 || strcmp(a1, "out") == 0);
+        ev.arg1 = ok && strcmp(a1, "in") == 0;
+      } else if (ev.what == "adc" || ev.what == "pin") {
+        ok = (n == 4);
+        if (ok) {
+          ev.arg1 = strtol(a1, nullptr, 0);
+          ev.arg2 = strtol(a2, nullptr, 0);
+        }
+      } else if (ev.what != "end") {
+        ok = false;
+      }
+    }
+
+    if (ok && ev.t_us < last_us) {
+      fprintf(stderr, "%s:%d: events out of order\n", path, line);
+      fclose(f);
+      return false;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "%s:%d: can't parse: %s", path, line, buf);
+      fclose(f);
+      return false;
+    }
+
+    last_us = ev.t_us;
+    events.push_back(ev);
+  }
+
+  fclose(f);
+  return true;
+}
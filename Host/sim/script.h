@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Scripted events for the simulator. One event per line:
+//
+//   <time> <event> [args]
+//
+// Time is virtual time since boot, e.g. "90", "1d2h", "3h30m", "1500ms"
+// (a bare number is seconds). Events:
+//
+//   power on|off       5V supply (the printer loses power with it)
+//   paper in|out       printer paper sensor
+//   adc <pin> <value>  analogRead(pin) returns value from now on
+//   pin <pin> <value>  digitalRead(pin) returns value from now on
+//   end                stop the simulation
+//
+// '#' starts a comment. Lines must be in time order.
+
+struct Event {
+  uint64_t t_us;
+  std::string what;
+  long arg1;
+  long arg2;
+  int line;
+};
+
+
+// Parse a duration like "1d2h30m" or "250ms"; returns false if malformed.
+bool parse_duration(const char *s, uint64_t& us);
+
+// Read a script; returns false (and prints why) on error.
+bool load_script(const char *path, std::vector<Event>& events);
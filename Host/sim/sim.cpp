@@ -0,0 +1,457 @@
+// Host simulator: runs an unmodified sketch against the host HAL, with a
+// scripted power supply and paper sensor and an emulated printer, in
+// virtual time. See README.md (Host Simulator) for how to use it.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <hal.h>
+#include <chrono.h>
+#include <millis64.h>
+#include "battery_emu.h"
+#include "printer_emu.h"
+#include "script.h"
+
+// PiMachine senses the 5V supply through a 2:1 divider on A2
+static const int power_pin = 2;
+static const int power_on_adc = 775;  // 5.0V / 2 on a 3.3V 10-bit ADC
+static const int power_off_adc = 512; // 3.3V / 2
+
+static PrinterEmu printer;
+
+// The Tiny's battery, on A0 through a divider: analogRead() * 625 / 128 is
+// millivolts.
+static const int battery_pin = 0;
+static BatteryEmu battery;
+static uint64_t battery_us = 0;  // drained up to here
+
+static std::vector<Event> events;
+static size_t next_event = 0;
+
+static uint64_t end_us = 7ull * 86400ull * 1000000ull; // a week
+static bool end_given = false;  // --end; otherwise a script's end is the end
+static uint64_t start_ms = 0;
+static bool quiet = false;
+static int off_pin = -1;
+
+static bool power = true;
+static bool paper = true;
+
+// Time with the machine unable to print (no power or no paper). The sketch
+// should be taking this (and a bit more, it waits to be sure) out of the
+// timestamps it prints.
+static uint64_t down_us = 0;
+static uint64_t down_since_us = 0;
+
+static struct timespec host_start;
+
+
+// What the sketch says on the console (one digit per line)
+struct Stats {
+  uint32_t lines;           // digit lines
+  uint32_t new_digits;      // lines that moved the high-water mark
+  uint32_t rollbacks;       // times the digit number went backwards
+  uint32_t reprinted;       // lines at or below the high-water mark
+  long high;                // highest digit number seen
+  uint32_t ts_backwards;    // printed timestamps that went backwards
+  uint64_t last_ts_ms;
+  long last_num;
+  int64_t drift_min_ms;
+  int64_t drift_max_ms;
+  int64_t drift_last_ms;
+  uint32_t power_outs;
+  uint32_t paper_outs;
+  uint32_t time_checks;
+  uint32_t time_errors;     // Time / millis64() disagreed with millis()
+} stats;
+
+// digits that made it onto paper, by number
+static std::map<long, char> on_paper;
+static uint32_t paper_mismatch = 0;
+
+
+static void report();
+
+
+static bool is_down()
+{
+  return !power || !paper;
+}
+
+
+static void set_power(bool on)
+{
+  if (on == power)
+    return;
+  bool was_down = is_down();
+  power = on;
+  if (!on)
+    stats.power_outs++;
+  hal::set_analog(power_pin, on ? power_on_adc : power_off_adc);
+  printer.power(on);
+  if (!was_down && is_down())
+    down_since_us = hal::now_us();
+  if (was_down && !is_down())
+    down_us += hal::now_us() - down_since_us;
+}
+
+
+static void set_paper(bool in)
+{
+  if (in == paper)
+    return;
+  bool was_down = is_down();
+  paper = in;
+  if (!in)
+    stats.paper_outs++;
+  printer.paper(in);
+  if (!was_down && is_down())
+    down_since_us = hal::now_us();
+  if (was_down && !is_down())
+    down_us += hal::now_us() - down_since_us;
+}
+
+
+static uint64_t down_now_us()
+{
+  return down_us + (is_down() ? hal::now_us() - down_since_us : 0);
+}
+
+
+static void time_hook(uint64_t now_us)
+{
+  while (next_event < events.size() && events[next_event].t_us <= now_us) {
+    const Event& ev = events[next_event++];
+    if (ev.what == "power")
+      set_power(ev.arg1 != 0);
+    else if (ev.what == "paper")
+      set_paper(ev.arg1 != 0);
+    else if (ev.what == "adc")
+      hal::set_analog(ev.arg1, ev.arg2);
+    else if (ev.what == "pin")
+      hal::set_digital(ev.arg1, ev.arg2);
+    else if (ev.what == "end")
+      end_us = ev.t_us;
+  }
+
+  if (battery.enabled() && now_us > battery_us) {
+    int mv = battery.drain(printer.charge(battery_us, now_us),
+                           printer.current_ma(now_us),
+                           printer.peak_ma(battery_us, now_us));
+    battery_us = now_us;
+    hal::set_analog(battery_pin, mv > 0 ? mv * 128 / 625 : 0);
+    if (battery.cut_off()) {
+      if (!quiet)
+        printf("[sim] battery protection cut off\n");
+      report();
+      exit(0);
+    }
+  }
+
+  if (now_us >= end_us) {
+    report();
+    exit(0);
+  }
+}
+
+
+static void output_hook(int pin, int value)
+{
+  if (pin == off_pin && value != 0) {
+    if (!quiet)
+      printf("[sim] power off pin set\n");
+    report();
+    exit(0);
+  }
+}
+
+
+// A console line from the sketch. Digit lines look like
+//   "123         | 5 |     0:01:23      4567"
+static void console_line(const char *line)
+{
+  long num;
+  char digit;
+  unsigned long h, m, s;
+  if (sscanf(line, "%ld | %c |%lu:%lu:%lu", &num, &digit, &h, &m, &s) != 5)
+    return;
+
+  stats.lines++;
+
+  if (stats.lines > 1 && num <= stats.last_num)
+    stats.rollbacks++;
+  if (num > stats.high) {
+    stats.high = num;
+    stats.new_digits++;
+  } else {
+    stats.reprinted++;
+  }
+  stats.last_num = num;
+
+  uint64_t ts_ms = ((uint64_t(h) * 60 + m) * 60 + s) * 1000;
+  if (ts_ms < stats.last_ts_ms)
+    stats.ts_backwards++;
+  stats.last_ts_ms = ts_ms;
+
+  // Timestamp is whole seconds; compare against time since boot with the
+  // scripted downtime taken out.
+  int64_t expect_ms = int64_t((hal::now_us() - down_now_us()) / 1000);
+  int64_t drift_ms = expect_ms - int64_t(ts_ms);
+  if (stats.lines == 1 || drift_ms < stats.drift_min_ms)
+    stats.drift_min_ms = drift_ms;
+  if (stats.lines == 1 || drift_ms > stats.drift_max_ms)
+    stats.drift_max_ms = drift_ms;
+  stats.drift_last_ms = drift_ms;
+}
+
+
+class Console : public SerialDevice {
+
+  public:
+
+    virtual void rx(uint8_t b)
+    {
+      if (!quiet)
+        fputc(b, stdout);
+      if (b == '\n') {
+        console_line(_line.c_str());
+        _line.clear();
+      } else if (b != '\r') {
+        _line += char(b);
+      }
+    }
+
+  private:
+
+    std::string _line;
+
+} console;
+
+
+static void printer_line(const PrinterEmu::Line& line)
+{
+  if (!line.on_paper || line.num < 0 || line.digit == 0)
+    return;
+  auto it = on_paper.find(line.num);
+  if (it != on_paper.end() && it->second != line.digit)
+    paper_mismatch++;
+  on_paper[line.num] = line.digit;
+}
+
+
+// Time (chrono.cpp) and millis64() should agree with millis(), including
+// having counted every rollover since boot. Virtual time can move between
+// calls, so check that each falls between readings taken before and after.
+static void check_time()
+{
+  uint64_t base = start_ms & ~0xffffffffull; // what a 64-bit count loses
+  uint64_t before = hal::now_ms() - base;
+  Time t = Time::now();
+  uint64_t t64 = uint64_t(get_time_ms64(t));
+  uint64_t m64 = millis64();
+  uint64_t after = hal::now_ms() - base;
+
+  stats.time_checks++;
+  if (t64 < before || t64 > after || m64 < before || m64 > after)
+    stats.time_errors++;
+}
+
+
+static void print_duration(const char *label, uint64_t us)
+{
+  uint64_t s = us / 1000000;
+  printf("%s%llud %02lluh %02llum %02llus\n", label,
+         (unsigned long long)(s / 86400), (unsigned long long)(s / 3600 % 24),
+         (unsigned long long)(s / 60 % 60), (unsigned long long)(s % 60));
+}
+
+
+static void report()
+{
+  struct timespec host_end;
+  clock_gettime(CLOCK_MONOTONIC, &host_end);
+  double host_s = double(host_end.tv_sec - host_start.tv_sec) +
+                  double(host_end.tv_nsec - host_start.tv_nsec) * 1e-9;
+  uint64_t virt_us = hal::now_us();
+  double virt_h = double(virt_us) / 3600e6;
+
+  printer.update();
+
+  // Digits that never made it onto paper. The console can be a line ahead
+  // of the printer (it isn't paced), so stop at the last one on paper;
+  // anything after that was still on its way when the run ended.
+  long paper_high = on_paper.empty() ? 0 : on_paper.rbegin()->first;
+  long missing = 0;
+  for (long n = 1; n <= paper_high; n++)
+    if (on_paper.find(n) == on_paper.end())
+      missing++;
+
+  fflush(stdout);
+  printf("\n");
+  printf("==== simulation report ====\n");
+  print_duration("virtual time:     ", virt_us);
+  print_duration("downtime:         ", down_now_us());
+  printf("host time:        %.2f s (%.0fx real time)\n", host_s,
+         host_s > 0. ? double(virt_us) / 1e6 / host_s : 0.);
+  printf("millis():         0x%08llx .. 0x%08llx, %llu rollover(s)\n",
+         (unsigned long long)uint32_t(start_ms),
+         (unsigned long long)uint32_t(hal::now_ms()),
+         (unsigned long long)((hal::now_ms() >> 32) - (start_ms >> 32)));
+  printf("time checks:      %u, %u error(s)\n", stats.time_checks,
+         stats.time_errors);
+  printf("events:           %u power out, %u paper out\n", stats.power_outs,
+         stats.paper_outs);
+  printf("digits:           %ld highest, %u lines, %u reprinted\n",
+         stats.high, stats.lines, stats.reprinted);
+  printf("throughput:       %.1f digits/hour (virtual), %.1f digits/s (host)\n",
+         virt_h > 0. ? stats.new_digits / virt_h : 0.,
+         host_s > 0. ? stats.new_digits / host_s : 0.);
+  printf("rollbacks:        %u\n", stats.rollbacks);
+  printf("timestamp drift:  %.1f s last, %.1f .. %.1f s, %u backwards\n",
+         stats.drift_last_ms / 1000., stats.drift_min_ms / 1000.,
+         stats.drift_max_ms / 1000., stats.ts_backwards);
+  printf("printer:          %u lines on paper, %u lost, %u bytes dropped, "
+         "%u status queries, %u reports\n", printer.lines_printed,
+         printer.lines_lost, printer.bytes_dropped, printer.status_queries,
+         printer.status_reports);
+  printf("paper:            %ld digit(s) missing, %u mismatched\n", missing,
+         paper_mismatch);
+  if (battery.enabled())
+    printf("battery:          %.1f%% left, lowest %d mV, %s\n",
+           battery.charge_pct(), battery.lowest_mv,
+           battery.cut_off() ? "protection cut off" : "ok");
+  fflush(stdout);
+}
+
+
+static void usage(const char *prog)
+{
+  printf("usage: %s [options]\n", prog);
+  printf("  --script FILE      scripted events (see sim/script.h)\n");
+  printf("  --end TIME         stop after this much virtual time (default: the\n");
+  printf("                     script's end, or 7d)\n");
+  printf("  --start-ms MS      millis() at boot\n");
+  printf("  --rollover-at TIME set --start-ms so millis() wraps at TIME\n");
+  printf("  --cpu-scale X      virtual time per host time (default 1;\n");
+  printf("                     0 = computing is free)\n");
+  printf("  --latency-us US    printer status response time (default 8300)\n");
+  printf("  --printer-boot-ms MS  printer ignores everything this long after\n");
+  printf("                     power on (default 0)\n");
+  printf("  --no-auto-status   printer firmware without automatic status (GS a)\n");
+  printf("  --off-pin PIN      stop when the sketch sets PIN (Tiny: 11)\n");
+  printf("  --pin PIN=VALUE    digitalRead(PIN) at boot\n");
+  printf("  --adc PIN=VALUE    analogRead(PIN) at boot (Tiny battery is 0)\n");
+  printf("  --battery MAH      a battery of this capacity on A0 (Tiny), drained\n");
+  printf("                     by the printer according to its heat settings\n");
+  printf("  --battery-pct P    how charged it starts (default 100)\n");
+  printf("  --battery-mohm R   its internal resistance (default 500)\n");
+  printf("  --battery-cutoff MV  its protection cutoff (default 3000)\n");
+  printf("  --flash FILE       keep the QSPI flash in FILE between runs\n");
+  printf("  --digits FILE      sketches with a FileSink write digits here\n");
+  printf("                     (a file, or a named pipe)\n");
+  printf("  --quiet            don't echo the console\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.last_num = -1;
+  stats.high = -1;
+
+  const char *script = nullptr;
+  uint64_t us;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--script") == 0 && val) {
+      script = val; i++;
+    } else if (strcmp(arg, "--end") == 0 && val && parse_duration(val, us)) {
+      end_us = us; end_given = true; i++;
+    } else if (strcmp(arg, "--start-ms") == 0 && val) {
+      start_ms = strtoull(val, nullptr, 0); i++;
+    } else if (strcmp(arg, "--rollover-at") == 0 && val && parse_duration(val, us)) {
+      start_ms = (1ull << 32) - us / 1000; i++;
+    } else if (strcmp(arg, "--cpu-scale") == 0 && val) {
+      hal::set_cpu_scale(atof(val)); i++;
+    } else if (strcmp(arg, "--latency-us") == 0 && val) {
+      printer.latency_us(strtoul(val, nullptr, 0)); i++;
+    } else if (strcmp(arg, "--printer-boot-ms") == 0 && val) {
+      printer.boot_us(strtoul(val, nullptr, 0) * 1000); i++;
+    } else if (strcmp(arg, "--no-auto-status") == 0) {
+      printer.auto_status(false);
+    } else if (strcmp(arg, "--off-pin") == 0 && val) {
+      off_pin = atoi(val); i++;
+    } else if (strcmp(arg, "--pin") == 0 && val && strchr(val, '=')) {
+      hal::set_digital(atoi(val), atoi(strchr(val, '=') + 1)); i++;
+    } else if (strcmp(arg, "--adc") == 0 && val && strchr(val, '=')) {
+      hal::set_analog(atoi(val), atoi(strchr(val, '=') + 1)); i++;
+    } else if (strcmp(arg, "--battery") == 0 && val) {
+      battery.capacity_mah(atof(val)); i++;
+    } else if (strcmp(arg, "--battery-pct") == 0 && val) {
+      battery.charge_pct(atof(val)); i++;
+    } else if (strcmp(arg, "--battery-mohm") == 0 && val) {
+      battery.resistance_mohm(atof(val)); i++;
+    } else if (strcmp(arg, "--battery-cutoff") == 0 && val) {
+      battery.cutoff_mv(atoi(val)); i++;
+    } else if (strcmp(arg, "--flash") == 0 && val) {
+      hal::set_flash_file(val); i++;
+    } else if (strcmp(arg, "--digits") == 0 && val) {
+      hal::set_digits_file(val); i++;
+    } else if (strcmp(arg, "--quiet") == 0) {
+      quiet = true;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (script != nullptr && !load_script(script, events))
+    return 1;
+
+  // A script that says when it ends runs that long, not the default week.
+  // (With --end, whichever comes first.)
+  if (!end_given) {
+    for (const Event& ev : events) {
+      if (ev.what == "end") {
+        end_us = ev.t_us;
+        break;
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &host_start);
+
+  hal::set_start_ms(start_ms);
+  hal::set_analog(power_pin, power_on_adc);
+  hal::set_time_hook(time_hook);
+  hal::set_output_hook(output_hook);
+
+  Serial.attach(&console);
+  Serial1.attach(&printer);
+  printer.on_line(printer_line);
+
+  time_hook(0); // events at time zero
+
+  // Time and millis64() have to be called at least once per rollover to
+  // keep count; start them off at boot in case the sketch doesn't use them.
+  check_time();
+
+  setup();
+  while (true) {
+    uint64_t before_us = hal::now_us();
+    loop();
+    // A loop() that doesn't touch time at all is idling; let a tick go by
+    // rather than spinning.
+    if (hal::now_us() == before_us)
+      yield();
+    check_time();
+  }
+}